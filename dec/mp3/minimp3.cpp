@@ -24,6 +24,21 @@
 #include "libc.h"
 #include "minimp3.h"
 
+// Set MINIMP3_SIMD to 0 to always use the scalar hybrid filterbank
+#ifndef MINIMP3_SIMD
+#define MINIMP3_SIMD 1
+#endif
+
+#if MINIMP3_SIMD && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define MINIMP3_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define MINIMP3_SIMD_X86 0
+#endif
+
 #define MP3_FRAME_SIZE 1152
 #define MP3_MAX_CODED_FRAME_SIZE 1792
 #define MP3_MAX_CHANNELS 2
@@ -143,6 +158,12 @@ static int32_t is_table_lsf[2][2][16];
 static int32_t csa_table[8][4];
 static float csa_table_float[8][4];
 static int32_t mdct_win[8][36];
+#if MINIMP3_SIMD_X86
+/* csa_table[j][0], [2] and [3] with j in lane j */
+static int32_t csa_lanes[3][8];
+/* mdct_win[block_type] in the even and mdct_win[block_type + 4] in the odd lanes */
+static int32_t mdct_win_lanes[4][36][8];
+#endif
 static int16_t window[512];
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1621,23 +1642,60 @@ static void imdct36(int *out, int *buf, int *in, int *win)
 	buf[8 - 4] = MULH(t0, win[18 + 8 - 4]);
 }
 
+/* index of the last band with a non zero sample + 1, the bands above are zero */
+static int compute_sblimit(granule_t *g) {
+	int32_t *ptr, *ptr1;
+	int v;
+
+	/* find last non zero block */
+	ptr = g->sb_hybrid + 576;
+	ptr1 = g->sb_hybrid + 2 * 18;
+	while (ptr >= ptr1) {
+		ptr -= 6;
+		v = ptr[0] | ptr[1] | ptr[2] | ptr[3] | ptr[4] | ptr[5];
+		if (v != 0)
+			break;
+	}
+	return ((ptr - g->sb_hybrid) / 18) + 1;
+}
+
+/* three short blocks of one band: imdct12, window and overlap */
+static void imdct_short(int32_t *out_ptr, int32_t *buf, int32_t *ptr, int32_t *win)
+{
+	int32_t out2[12];
+	int i;
+
+	for(i=0; i<6; i++){
+		*out_ptr = buf[i];
+		out_ptr += SBLIMIT;
+	}
+	imdct12(out2, ptr + 0);
+	for(i=0;i<6;i++) {
+		*out_ptr = MULH(out2[i], win[i]) + buf[i + 6*1];
+		buf[i + 6*2] = MULH(out2[i + 6], win[i + 6]);
+		out_ptr += SBLIMIT;
+	}
+	imdct12(out2, ptr + 1);
+	for(i=0;i<6;i++) {
+		*out_ptr = MULH(out2[i], win[i]) + buf[i + 6*2];
+		buf[i + 6*0] = MULH(out2[i + 6], win[i + 6]);
+		out_ptr += SBLIMIT;
+	}
+	imdct12(out2, ptr + 2);
+	for(i=0;i<6;i++) {
+		buf[i + 6*0] = MULH(out2[i], win[i]) + buf[i + 6*0];
+		buf[i + 6*1] = MULH(out2[i + 6], win[i + 6]);
+		buf[i + 6*2] = 0;
+	}
+}
+
 static void compute_imdct(
 	mp3_context_t *s, granule_t *g, int32_t *sb_samples, int32_t *mdct_buf
 	) {
-		int32_t *ptr, *win, *win1, *buf, *out_ptr, *ptr1;
-		int32_t out2[12];
-		int i, j, mdct_long_end, v, sblimit;
-
-		/* find last non zero block */
-		ptr = g->sb_hybrid + 576;
-		ptr1 = g->sb_hybrid + 2 * 18;
-		while (ptr >= ptr1) {
-			ptr -= 6;
-			v = ptr[0] | ptr[1] | ptr[2] | ptr[3] | ptr[4] | ptr[5];
-			if (v != 0)
-				break;
-		}
-		sblimit = ((ptr - g->sb_hybrid) / 18) + 1;
+		int32_t *ptr, *win, *win1, *buf, *out_ptr;
+		int i, j, mdct_long_end, sblimit;
+
+		sblimit = compute_sblimit(g);
 
 		if (g->block_type == 2) {
 			/* XXX: check for 8000 Hz */
@@ -1671,28 +1729,7 @@ static void compute_imdct(
 			win = mdct_win[2] + ((4 * 36) & -(j & 1));
 			out_ptr = sb_samples + j;
 
-			for(i=0; i<6; i++){
-				*out_ptr = buf[i];
-				out_ptr += SBLIMIT;
-			}
-			imdct12(out2, ptr + 0);
-			for(i=0;i<6;i++) {
-				*out_ptr = MULH(out2[i], win[i]) + buf[i + 6*1];
-				buf[i + 6*2] = MULH(out2[i + 6], win[i + 6]);
-				out_ptr += SBLIMIT;
-			}
-			imdct12(out2, ptr + 1);
-			for(i=0;i<6;i++) {
-				*out_ptr = MULH(out2[i], win[i]) + buf[i + 6*2];
-				buf[i + 6*0] = MULH(out2[i + 6], win[i + 6]);
-				out_ptr += SBLIMIT;
-			}
-			imdct12(out2, ptr + 2);
-			for(i=0;i<6;i++) {
-				buf[i + 6*0] = MULH(out2[i], win[i]) + buf[i + 6*0];
-				buf[i + 6*1] = MULH(out2[i + 6], win[i + 6]);
-				buf[i + 6*2] = 0;
-			}
+			imdct_short(out_ptr, buf, ptr, win);
 			ptr += 18;
 			buf += 18;
 		}
@@ -1709,6 +1746,276 @@ static void compute_imdct(
 		}
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// SIMD hybrid filterbank, see minimp3_hybrid_template.h
+//
+// MULH and MULL multiply the even and the odd lanes separately (mul_epi32 takes
+// the low 32 bits of each 64-bit lane) and blend the 32 result bits of the two
+// 64-bit products back into one vector, so the lanes get the exact scalar result.
+
+static void (*hybrid_antialias)(mp3_context_t *s, granule_t *g) = compute_antialias;
+static void (*hybrid_imdct)(mp3_context_t *s, granule_t *g, int32_t *sb_samples, int32_t *mdct_buf) = compute_imdct;
+
+#if MINIMP3_SIMD_X86
+
+#if defined(__GNUC__)
+#define HV_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define HV_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HV_TARGET_SSE41
+#define HV_TARGET_AVX2
+#endif
+
+#define HV_CAT2(a, b) a##_##b
+#define HV_CAT(a, b) HV_CAT2(a, b)
+#define HV(name) HV_CAT(name, HV_SUFFIX)
+
+/* 4 rows of 18 words at rows, rows + 18, ... to 18 vectors, row k in lane k */
+static INLINE void transpose4_in(const int32_t *rows, __m128i *x)
+{
+	__m128i r0, r1, r2, r3, t0, t1, t2, t3;
+	int c;
+
+	for(c=0;c<16;c+=4) {
+		r0 = _mm_loadu_si128((const __m128i*)(rows + 0*18 + c));
+		r1 = _mm_loadu_si128((const __m128i*)(rows + 1*18 + c));
+		r2 = _mm_loadu_si128((const __m128i*)(rows + 2*18 + c));
+		r3 = _mm_loadu_si128((const __m128i*)(rows + 3*18 + c));
+		t0 = _mm_unpacklo_epi32(r0, r1);
+		t1 = _mm_unpacklo_epi32(r2, r3);
+		t2 = _mm_unpackhi_epi32(r0, r1);
+		t3 = _mm_unpackhi_epi32(r2, r3);
+		x[c + 0] = _mm_unpacklo_epi64(t0, t1);
+		x[c + 1] = _mm_unpackhi_epi64(t0, t1);
+		x[c + 2] = _mm_unpacklo_epi64(t2, t3);
+		x[c + 3] = _mm_unpackhi_epi64(t2, t3);
+	}
+	r0 = _mm_loadl_epi64((const __m128i*)(rows + 0*18 + 16));
+	r1 = _mm_loadl_epi64((const __m128i*)(rows + 1*18 + 16));
+	r2 = _mm_loadl_epi64((const __m128i*)(rows + 2*18 + 16));
+	r3 = _mm_loadl_epi64((const __m128i*)(rows + 3*18 + 16));
+	t0 = _mm_unpacklo_epi32(r0, r1);
+	t1 = _mm_unpacklo_epi32(r2, r3);
+	x[16] = _mm_unpacklo_epi64(t0, t1);
+	x[17] = _mm_unpackhi_epi64(t0, t1);
+}
+
+/* the inverse of transpose4_in() */
+static INLINE void transpose4_out(const __m128i *x, int32_t *rows)
+{
+	__m128i t0, t1, t2, t3;
+	int c;
+
+	for(c=0;c<16;c+=4) {
+		t0 = _mm_unpacklo_epi32(x[c + 0], x[c + 1]);
+		t1 = _mm_unpacklo_epi32(x[c + 2], x[c + 3]);
+		t2 = _mm_unpackhi_epi32(x[c + 0], x[c + 1]);
+		t3 = _mm_unpackhi_epi32(x[c + 2], x[c + 3]);
+		_mm_storeu_si128((__m128i*)(rows + 0*18 + c), _mm_unpacklo_epi64(t0, t1));
+		_mm_storeu_si128((__m128i*)(rows + 1*18 + c), _mm_unpackhi_epi64(t0, t1));
+		_mm_storeu_si128((__m128i*)(rows + 2*18 + c), _mm_unpacklo_epi64(t2, t3));
+		_mm_storeu_si128((__m128i*)(rows + 3*18 + c), _mm_unpackhi_epi64(t2, t3));
+	}
+	t0 = _mm_unpacklo_epi32(x[16], x[17]);
+	t1 = _mm_unpackhi_epi32(x[16], x[17]);
+	_mm_storel_epi64((__m128i*)(rows + 0*18 + 16), t0);
+	_mm_storel_epi64((__m128i*)(rows + 1*18 + 16), _mm_unpackhi_epi64(t0, t0));
+	_mm_storel_epi64((__m128i*)(rows + 2*18 + 16), t1);
+	_mm_storel_epi64((__m128i*)(rows + 3*18 + 16), _mm_unpackhi_epi64(t1, t1));
+}
+
+//------------------------------------------------------------------------------
+// SSE4.1, 4 bands per group
+
+#define hv_t __m128i
+#define HV_LANES 4
+#define HV_SUFFIX sse41
+#define HV_TARGET HV_TARGET_SSE41
+
+static HV_TARGET INLINE hv_t vload_sse41(const int32_t *p) { return _mm_loadu_si128((const __m128i*)p); }
+static HV_TARGET INLINE void vstore_sse41(int32_t *p, hv_t a) { _mm_storeu_si128((__m128i*)p, a); }
+static HV_TARGET INLINE hv_t set1_sse41(int32_t a) { return _mm_set1_epi32(a); }
+static HV_TARGET INLINE hv_t add_sse41(hv_t a, hv_t b) { return _mm_add_epi32(a, b); }
+static HV_TARGET INLINE hv_t sub_sse41(hv_t a, hv_t b) { return _mm_sub_epi32(a, b); }
+static HV_TARGET INLINE hv_t shl_sse41(hv_t a, int n) { return _mm_slli_epi32(a, n); }
+static HV_TARGET INLINE hv_t sra_sse41(hv_t a, int n) { return _mm_srai_epi32(a, n); }
+static HV_TARGET INLINE hv_t reverse_sse41(hv_t a) { return _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 1, 2, 3)); }
+
+static HV_TARGET INLINE hv_t mulh_sse41(hv_t a, hv_t b)
+{
+	hv_t even = _mm_mul_epi32(a, b);
+	hv_t odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_blend_epi16(_mm_srli_epi64(even, 32), odd, 0xcc);
+}
+
+/* MULH and MULL by a constant, the odd lanes of the broadcast take the place of the even ones */
+static HV_TARGET INLINE hv_t mulhc_sse41(hv_t a, int32_t c)
+{
+	hv_t b = _mm_set1_epi32(c);
+	hv_t even = _mm_mul_epi32(a, b);
+	hv_t odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), b);
+	return _mm_blend_epi16(_mm_srli_epi64(even, 32), odd, 0xcc);
+}
+
+static HV_TARGET INLINE hv_t mullc_sse41(hv_t a, int32_t c)
+{
+	hv_t b = _mm_set1_epi32(c);
+	hv_t even = _mm_mul_epi32(a, b);
+	hv_t odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), b);
+	return _mm_blend_epi16(_mm_srli_epi64(even, FRAC_BITS), _mm_slli_epi64(odd, 32 - FRAC_BITS), 0xcc);
+}
+
+static HV_TARGET INLINE void transpose_in_sse41(const int32_t *rows, hv_t *x) { transpose4_in(rows, x); }
+static HV_TARGET INLINE void transpose_out_sse41(const hv_t *x, int32_t *rows) { transpose4_out(x, rows); }
+
+#include "minimp3_hybrid_template.h"
+
+#undef hv_t
+#undef HV_LANES
+#undef HV_SUFFIX
+#undef HV_TARGET
+
+//------------------------------------------------------------------------------
+// AVX2, 8 bands per group
+
+#define hv_t __m256i
+#define HV_LANES 8
+#define HV_SUFFIX avx2
+#define HV_TARGET HV_TARGET_AVX2
+
+static HV_TARGET INLINE hv_t vload_avx2(const int32_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+static HV_TARGET INLINE void vstore_avx2(int32_t *p, hv_t a) { _mm256_storeu_si256((__m256i*)p, a); }
+static HV_TARGET INLINE hv_t set1_avx2(int32_t a) { return _mm256_set1_epi32(a); }
+static HV_TARGET INLINE hv_t add_avx2(hv_t a, hv_t b) { return _mm256_add_epi32(a, b); }
+static HV_TARGET INLINE hv_t sub_avx2(hv_t a, hv_t b) { return _mm256_sub_epi32(a, b); }
+static HV_TARGET INLINE hv_t shl_avx2(hv_t a, int n) { return _mm256_slli_epi32(a, n); }
+static HV_TARGET INLINE hv_t sra_avx2(hv_t a, int n) { return _mm256_srai_epi32(a, n); }
+static HV_TARGET INLINE hv_t reverse_avx2(hv_t a) { return _mm256_permutevar8x32_epi32(a, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+
+static HV_TARGET INLINE hv_t mulh_avx2(hv_t a, hv_t b)
+{
+	hv_t even = _mm256_mul_epi32(a, b);
+	hv_t odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+	return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+}
+
+/* MULH and MULL by a constant, the odd lanes of the broadcast take the place of the even ones */
+static HV_TARGET INLINE hv_t mulhc_avx2(hv_t a, int32_t c)
+{
+	hv_t b = _mm256_set1_epi32(c);
+	hv_t even = _mm256_mul_epi32(a, b);
+	hv_t odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), b);
+	return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+}
+
+static HV_TARGET INLINE hv_t mullc_avx2(hv_t a, int32_t c)
+{
+	hv_t b = _mm256_set1_epi32(c);
+	hv_t even = _mm256_mul_epi32(a, b);
+	hv_t odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), b);
+	return _mm256_blend_epi32(_mm256_srli_epi64(even, FRAC_BITS), _mm256_slli_epi64(odd, 32 - FRAC_BITS), 0xaa);
+}
+
+/* bands 0 .. 3 in the low and 4 .. 7 in the high 128-bit lane */
+static HV_TARGET INLINE void transpose_in_avx2(const int32_t *rows, hv_t *x)
+{
+	__m128i lo[18], hi[18];
+	int i;
+
+	transpose4_in(rows, lo);
+	transpose4_in(rows + 4*18, hi);
+	for(i=0;i<18;i++)
+		x[i] = _mm256_inserti128_si256(_mm256_castsi128_si256(lo[i]), hi[i], 1);
+}
+
+static HV_TARGET INLINE void transpose_out_avx2(const hv_t *x, int32_t *rows)
+{
+	__m128i lo[18], hi[18];
+	int i;
+
+	for(i=0;i<18;i++) {
+		lo[i] = _mm256_castsi256_si128(x[i]);
+		hi[i] = _mm256_extracti128_si256(x[i], 1);
+	}
+	transpose4_out(lo, rows);
+	transpose4_out(hi, rows + 4*18);
+}
+
+#include "minimp3_hybrid_template.h"
+
+#undef hv_t
+#undef HV_LANES
+#undef HV_SUFFIX
+#undef HV_TARGET
+
+static int cpu_has_sse41(void)
+{
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 1);
+	return (info[2] & (1 << 19)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+/* checks CPUID (and that the OS saves the YMM registers) for AVX2 support */
+static int cpu_has_avx2(void)
+{
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return 0;
+
+	/* OSXSAVE and AVX */
+	__cpuid(info, 1);
+	if ((info[2] & (3 << 27)) != (3 << 27))
+		return 0;
+
+	/* XMM and YMM state enabled by the OS */
+	if ((_xgetbv(0) & 6) != 6)
+		return 0;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // MINIMP3_SIMD_X86
+
+/* builds the lane tables and selects the widest hybrid filterbank the CPU has */
+static void hybrid_init(void)
+{
+#if MINIMP3_SIMD_X86
+	int i, j, k;
+
+	for(j=0;j<8;j++) {
+		csa_lanes[0][j] = csa_table[j][0];
+		csa_lanes[1][j] = csa_table[j][2];
+		csa_lanes[2][j] = csa_table[j][3];
+	}
+	for(j=0;j<4;j++)
+		for(i=0;i<36;i++)
+			for(k=0;k<8;k++)
+				mdct_win_lanes[j][i][k] = mdct_win[j + 4 * (k & 1)][i];
+
+	if (cpu_has_avx2()) {
+		hybrid_antialias = compute_antialias_avx2;
+		hybrid_imdct = compute_imdct_avx2;
+	} else if (cpu_has_sse41()) {
+		hybrid_antialias = compute_antialias_sse41;
+		hybrid_imdct = compute_imdct_sse41;
+	}
+#endif
+}
+
 #define SUM8(sum, op, w, p) \
 {                                               \
 	sum op MULS((w)[0 * 64], p[0 * 64]);\
@@ -2343,8 +2650,8 @@ static int mp_decode_layer3(mp3_context_t *s) {
 		for(ch=0;ch<s->nb_channels;ch++) {
 			g = &granules[ch][gr];
 			reorder_block(s, g);
-			compute_antialias(s, g);
-			compute_imdct(s, g, &s->sb_samples[ch][18 * gr][0], s->mdct_buf[ch]);
+			hybrid_antialias(s, g);
+			hybrid_imdct(s, g, &s->sb_samples[ch][18 * gr][0], s->mdct_buf[ch]);
 		}
 	} /* gr */
 	return nb_granules * 18;
@@ -2562,6 +2869,7 @@ static int mp3_decode_init(mp3_context_t *s) {
 				mdct_win[j + 4][i + 1] = -mdct_win[j][i + 1];
 			}
 		}
+		hybrid_init();
 		init = 1;
 	}
 	return 0;
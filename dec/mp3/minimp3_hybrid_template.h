@@ -0,0 +1,258 @@
+/*
+ * Vector hybrid filterbank (antialias, imdct36, imdct12) of the MPEG Audio
+ * Layer III decoder, included by minimp3.cpp once per instruction set.
+ *
+ * The includer defines:
+ *   HV_LANES    number of 32-bit lanes of hv_t (4 or 8)
+ *   HV(name)    name with the instruction set suffix
+ *   HV_TARGET   target attribute of the functions
+ * and the vector operations HV(vload) ... HV(transpose_out) on hv_t.
+ *
+ * The imdct works on HV_LANES bands at once, band k of a group in lane k:
+ * the 18 lines of the bands are transposed to 18 vectors, so the butterflies
+ * of the scalar code map one to one onto lane operations, and sample i of
+ * the group is one store to sb_samples[i]. The groups start at an even band,
+ * so the frequency inversion of the odd bands is a fixed lane pattern of the
+ * window (mdct_win_lanes). The results are bit exact with the scalar code.
+ */
+
+/* the 8 butterflies between two bands, butterfly j in lane j */
+static HV_TARGET void HV(compute_antialias)(mp3_context_t *, granule_t *g) {
+	int32_t *ptr;
+	int n, i, j;
+
+	/* we antialias only "long" bands */
+	if (g->block_type == 2) {
+		if (!g->switch_point)
+			return;
+		/* XXX: check this for 8000Hz case */
+		n = 1;
+	} else {
+		n = SBLIMIT - 1;
+	}
+
+	ptr = g->sb_hybrid + 18;
+	for(i = n;i > 0;i--) {
+		for(j = 0;j < 8;j += HV_LANES) {
+			hv_t tmp0, tmp1, tmp2;
+
+			tmp0 = HV(reverse)(HV(vload)(ptr - j - HV_LANES));
+			tmp1 = HV(vload)(ptr + j);
+			tmp2 = HV(mulh)(HV(add)(tmp0, tmp1), HV(vload)(csa_lanes[0] + j));
+			HV(vstore)(ptr - j - HV_LANES, HV(reverse)(
+				HV(shl)(HV(sub)(tmp2, HV(mulh)(tmp1, HV(vload)(csa_lanes[1] + j))), 2)));
+			HV(vstore)(ptr + j,
+				HV(shl)(HV(add)(tmp2, HV(mulh)(tmp0, HV(vload)(csa_lanes[2] + j))), 2));
+		}
+		ptr += 18;
+	}
+}
+
+static HV_TARGET INLINE void HV(imdct12)(hv_t *out, const hv_t *in)
+{
+	hv_t in0, in1, in2, in3, in4, in5, t1, t2;
+
+	in0= in[0*3];
+	in1= HV(add)(in[1*3], in[0*3]);
+	in2= HV(add)(in[2*3], in[1*3]);
+	in3= HV(add)(in[3*3], in[2*3]);
+	in4= HV(add)(in[4*3], in[3*3]);
+	in5= HV(add)(in[5*3], in[4*3]);
+	in5 = HV(add)(in5, in3);
+	in3 = HV(add)(in3, in1);
+
+	in2= HV(mulhc)(HV(shl)(in2, 1), C3);
+	in3= HV(mulhc)(HV(shl)(in3, 2), C3);
+
+	t1 = HV(sub)(in0, in4);
+	t2 = HV(mulhc)(HV(shl)(HV(sub)(in1, in5), 1), icos36h[4]);
+
+	out[ 7]=
+		out[10]= HV(add)(t1, t2);
+	out[ 1]=
+		out[ 4]= HV(sub)(t1, t2);
+
+	in0 = HV(add)(in0, HV(sra)(in4, 1));
+	in4 = HV(add)(in0, in2);
+	in5 = HV(add)(in5, HV(shl)(in1, 1));
+	in1 = HV(mulhc)(HV(add)(in5, in3), icos36h[1]);
+	out[ 8]=
+		out[ 9]= HV(add)(in4, in1);
+	out[ 2]=
+		out[ 3]= HV(sub)(in4, in1);
+
+	in0 = HV(sub)(in0, in2);
+	in5 = HV(mulhc)(HV(shl)(HV(sub)(in5, in3), 1), icos36h[7]);
+	out[ 0]=
+		out[ 5]= HV(sub)(in0, in5);
+	out[ 6]=
+		out[11]= HV(add)(in0, in5);
+}
+
+/* imdct36() of the bands in[0 .. HV_LANES - 1], win: mdct_win_lanes[block_type] */
+static HV_TARGET void HV(imdct36)(int32_t *out, int32_t *buf, const int32_t *in, const int32_t (*win)[8])
+{
+	int i, j;
+	hv_t t0, t1, t2, t3, s0, s1, s2, s3;
+	hv_t x[18], tmp[18], b[18], *tmp1, *in1;
+
+	HV(transpose_in)(in, x);
+
+	for(i=17;i>=1;i--)
+		x[i] = HV(add)(x[i], x[i-1]);
+	for(i=17;i>=3;i-=2)
+		x[i] = HV(add)(x[i], x[i-2]);
+
+	for(j=0;j<2;j++) {
+		tmp1 = tmp + j;
+		in1 = x + j;
+		t2 = HV(sub)(HV(add)(in1[2*4], in1[2*8]), in1[2*2]);
+
+		t3 = HV(add)(in1[2*0], HV(sra)(in1[2*6], 1));
+		t1 = HV(sub)(in1[2*0], in1[2*6]);
+		tmp1[ 6] = HV(sub)(t1, HV(sra)(t2, 1));
+		tmp1[16] = HV(add)(t1, t2);
+
+		t0 = HV(mulhc)(HV(shl)(HV(add)(in1[2*2], in1[2*4]), 1), C2);
+		t1 = HV(mulhc)(HV(sub)(in1[2*4], in1[2*8]), -2*C8);
+		t2 = HV(mulhc)(HV(shl)(HV(add)(in1[2*2], in1[2*8]), 1), -C4);
+
+		tmp1[10] = HV(sub)(HV(sub)(t3, t0), t2);
+		tmp1[ 2] = HV(add)(HV(add)(t3, t0), t1);
+		tmp1[14] = HV(sub)(HV(add)(t3, t2), t1);
+
+		tmp1[ 4] = HV(mulhc)(HV(shl)(HV(sub)(HV(add)(in1[2*5], in1[2*7]), in1[2*1]), 1), -C3);
+		t2 = HV(mulhc)(HV(shl)(HV(add)(in1[2*1], in1[2*5]), 1), C1);
+		t3 = HV(mulhc)(HV(sub)(in1[2*5], in1[2*7]), -2*C7);
+		t0 = HV(mulhc)(HV(shl)(in1[2*3], 1), C3);
+
+		t1 = HV(mulhc)(HV(shl)(HV(add)(in1[2*1], in1[2*7]), 1), -C5);
+
+		tmp1[ 0] = HV(add)(HV(add)(t2, t3), t0);
+		tmp1[12] = HV(sub)(HV(add)(t2, t1), t0);
+		tmp1[ 8] = HV(sub)(HV(sub)(t3, t1), t0);
+	}
+
+	HV(transpose_in)(buf, b);
+
+	i = 0;
+	for(j=0;j<4;j++) {
+		t0 = tmp[i];
+		t1 = tmp[i + 2];
+		s0 = HV(add)(t1, t0);
+		s2 = HV(sub)(t1, t0);
+
+		t2 = tmp[i + 1];
+		t3 = tmp[i + 3];
+		s1 = HV(mulhc)(HV(shl)(HV(add)(t3, t2), 1), icos36h[j]);
+		s3 = HV(mullc)(HV(sub)(t3, t2), icos36[8 - j]);
+
+		t0 = HV(add)(s0, s1);
+		t1 = HV(sub)(s0, s1);
+		HV(vstore)(out + (9 + j)*SBLIMIT, HV(add)(HV(mulh)(t1, HV(vload)(win[9 + j])), b[9 + j]));
+		HV(vstore)(out + (8 - j)*SBLIMIT, HV(add)(HV(mulh)(t1, HV(vload)(win[8 - j])), b[8 - j]));
+		b[9 + j] = HV(mulh)(t0, HV(vload)(win[18 + 9 + j]));
+		b[8 - j] = HV(mulh)(t0, HV(vload)(win[18 + 8 - j]));
+
+		t0 = HV(add)(s2, s3);
+		t1 = HV(sub)(s2, s3);
+		HV(vstore)(out + (9 + 8 - j)*SBLIMIT, HV(add)(HV(mulh)(t1, HV(vload)(win[9 + 8 - j])), b[9 + 8 - j]));
+		HV(vstore)(out + (        j)*SBLIMIT, HV(add)(HV(mulh)(t1, HV(vload)(win[        j])), b[        j]));
+		b[9 + 8 - j] = HV(mulh)(t0, HV(vload)(win[18 + 9 + 8 - j]));
+		b[      + j] = HV(mulh)(t0, HV(vload)(win[18         + j]));
+		i += 4;
+	}
+
+	s0 = tmp[16];
+	s1 = HV(mulhc)(HV(shl)(tmp[17], 1), icos36h[4]);
+	t0 = HV(add)(s0, s1);
+	t1 = HV(sub)(s0, s1);
+	HV(vstore)(out + (9 + 4)*SBLIMIT, HV(add)(HV(mulh)(t1, HV(vload)(win[9 + 4])), b[9 + 4]));
+	HV(vstore)(out + (8 - 4)*SBLIMIT, HV(add)(HV(mulh)(t1, HV(vload)(win[8 - 4])), b[8 - 4]));
+	b[9 + 4] = HV(mulh)(t0, HV(vload)(win[18 + 9 + 4]));
+	b[8 - 4] = HV(mulh)(t0, HV(vload)(win[18 + 8 - 4]));
+
+	HV(transpose_out)(b, buf);
+}
+
+/* imdct_short() of the bands in[0 .. HV_LANES - 1], win: mdct_win_lanes[2] */
+static HV_TARGET void HV(imdct_short)(int32_t *out, int32_t *buf, const int32_t *in, const int32_t (*win)[8])
+{
+	hv_t x[18], b[18], out2[12];
+	int i;
+
+	HV(transpose_in)(in, x);
+	HV(transpose_in)(buf, b);
+
+	for(i=0; i<6; i++)
+		HV(vstore)(out + i*SBLIMIT, b[i]);
+	HV(imdct12)(out2, x + 0);
+	for(i=0;i<6;i++) {
+		HV(vstore)(out + (6 + i)*SBLIMIT, HV(add)(HV(mulh)(out2[i], HV(vload)(win[i])), b[i + 6*1]));
+		b[i + 6*2] = HV(mulh)(out2[i + 6], HV(vload)(win[i + 6]));
+	}
+	HV(imdct12)(out2, x + 1);
+	for(i=0;i<6;i++) {
+		HV(vstore)(out + (12 + i)*SBLIMIT, HV(add)(HV(mulh)(out2[i], HV(vload)(win[i])), b[i + 6*2]));
+		b[i + 6*0] = HV(mulh)(out2[i + 6], HV(vload)(win[i + 6]));
+	}
+	HV(imdct12)(out2, x + 2);
+	for(i=0;i<6;i++) {
+		b[i + 6*0] = HV(add)(HV(mulh)(out2[i], HV(vload)(win[i])), b[i + 6*0]);
+		b[i + 6*1] = HV(mulh)(out2[i + 6], HV(vload)(win[i + 6]));
+		b[i + 6*2] = HV(set1)(0);
+	}
+
+	HV(transpose_out)(b, buf);
+}
+
+static HV_TARGET void HV(compute_imdct)(
+	mp3_context_t *, granule_t *g, int32_t *sb_samples, int32_t *mdct_buf
+	) {
+		int32_t *ptr, *buf;
+		int i, j, mdct_long_end, sblimit;
+
+		sblimit = compute_sblimit(g);
+
+		if (g->block_type == 2) {
+			/* XXX: check for 8000 Hz */
+			if (g->switch_point)
+				mdct_long_end = 2;
+			else
+				mdct_long_end = 0;
+		} else {
+			mdct_long_end = sblimit;
+		}
+
+		j = 0;
+		/* the two long bands of a switch point have their own window */
+		if (g->switch_point) {
+			for(;j<2 && j<mdct_long_end;j++)
+				imdct36(sb_samples + j, mdct_buf + 18*j, g->sb_hybrid + 18*j,
+					mdct_win[0] + ((4 * 36) & -(j & 1)));
+		}
+		/* the bands above sblimit are zero, imdct36() only overlaps them as the zero bands below do */
+		for(;j<mdct_long_end && j + HV_LANES <= SBLIMIT;j+=HV_LANES)
+			HV(imdct36)(sb_samples + j, mdct_buf + 18*j, g->sb_hybrid + 18*j, mdct_win_lanes[g->block_type]);
+		for(;j<mdct_long_end;j++)
+			imdct36(sb_samples + j, mdct_buf + 18*j, g->sb_hybrid + 18*j,
+				mdct_win[g->block_type] + ((4 * 36) & -(j & 1)));
+
+		for(;j + HV_LANES <= sblimit;j+=HV_LANES)
+			HV(imdct_short)(sb_samples + j, mdct_buf + 18*j, g->sb_hybrid + 18*j, mdct_win_lanes[2]);
+		for(;j<sblimit;j++)
+			imdct_short(sb_samples + j, mdct_buf + 18*j, g->sb_hybrid + 18*j,
+				mdct_win[2] + ((4 * 36) & -(j & 1)));
+
+		/* zero bands */
+		for(;j<SBLIMIT;j++) {
+			/* overlap */
+			ptr = sb_samples + j;
+			buf = mdct_buf + 18*j;
+			for(i=0;i<18;i++) {
+				*ptr = buf[i];
+				buf[i] = 0;
+				ptr += SBLIMIT;
+			}
+		}
+}
@@ -7,6 +7,8 @@
 
 
 #include <iostream>
+#include <atomic>
+#include <thread>
 #include "haos_api.h"
 #include "haos.h"
 #include "bitripper_sim.h"
@@ -14,9 +16,13 @@
 #define BUFFER_COUNT 1
 #define MP3_FRAME_SIZE 1152
 #define PCM16_SCALE (32768.0) // 2^15
-#define MP3_INPUT_CHUNK_SIZE 768
+// najveća dužina Layer III frejma u bajtovima (320 kbps na 32 kHz, sa padding bajtom)
+#define MP3_MAX_FRAME_BYTES 1441
+// broj bajtova koji se pretraže u jednom pozivu kada se traži zaglavlje frejma
+#define MP3_RESYNC_BYTES_MAX (MP3_MAX_FRAME_BYTES * 2)
 
 static char bs_buffer[MP3_MAX_SAMPLES_PER_FRAME * BUFFER_COUNT];
+static uint32_t bs_words[MP3_MAX_FRAME_BYTES / 4];
 static signed short sample_buffer[MP3_MAX_SAMPLES_PER_FRAME * BUFFER_COUNT];
 
 
@@ -39,6 +45,60 @@ static HAOS_PcmSample_t* PingPongSample_buffer_EndPtr[2];
 
 static int PCMAvailable = 0;
 
+// da li BitRipper stoji na početku frejma (prethodni frejm je imao ispravno zaglavlje)
+static bool mp3Decoder_synced = false;
+
+// ------------------------------------------------
+// Dekodovanje unapred (decodeAheadFrames != 0): radna nit dekoduje frejmove u PCM prsten
+// brikova, AFAP samo preuzima brikove iz prstena. Prsten je lock-free (jedan proizvođač,
+// jedan potrošač), indeksi su HAOS_BrickRing_t.
+// ------------------------------------------------
+
+// najviše frejmova dekodovanih unapred
+#define MP3_DECODE_AHEAD_FRAMES_MAX 8
+
+// najmanji stepen dvojke >= n
+static constexpr uint32_t mp3Decoder_pow2(uint32_t n)
+{
+	return (n <= 1) ? 1 : 2 * mp3Decoder_pow2((n + 1) / 2);
+}
+
+// broj brikova u prstenu, dovoljno za MP3_DECODE_AHEAD_FRAMES_MAX frejmova
+#define MP3_PCM_RING_BRICKS mp3Decoder_pow2((MP3_DECODE_AHEAD_FRAMES_MAX * MP3_FRAME_SIZE + BRICK_SIZE - 1) / BRICK_SIZE)
+
+// jedan brik oba kanala sa frekvencijom odabiranja frejma iz kog je
+typedef struct
+{
+	HAOS_BrickBuffer_t data[2];
+	int32_t sampleRate;
+} Mp3Decoder_RingBrick_t;
+
+static struct Mp3DecodeAhead_t
+{
+	HAOS_BrickRing_t ring;
+	Mp3Decoder_RingBrick_t bricks[MP3_PCM_RING_BRICKS];
+
+	bool enabled;				// nit je pokrenuta u postkick-u, kasnije promene MCV-a se ne primenjuju
+	uint32_t aheadBricks;		// najviše brikova u prstenu (decodeAheadFrames frejmova)
+	uint32_t fillCnt;			// broj odbiraka upisanih u brik koji nit trenutno puni
+
+	std::thread thread;
+	std::atomic<bool> stop;		// postavlja se na izlasku iz programa
+	std::atomic<bool> finished;	// nit je upisala poslednji brik
+
+	// zaustaviti nit ako program izađe pre kraja toka (npr. Ctrl+C dok nit čeka mesto u prstenu)
+	~Mp3DecodeAhead_t()
+	{
+		stop.store(true);
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+	}
+} mp3Decoder_ahead;
+
+static void mp3Decoder_decodeAheadThread(void* pCore);
+
 static mp3_info_t info;
 static mp3_decoder_t mp3;
 
@@ -46,13 +106,14 @@ struct
 {
 	unsigned int mp3Enable;
 	unsigned int srcActiveChannels[NUMBER_OF_IO_CHANNELS];
+	unsigned int decodeAheadFrames;		// 0: dekodovanje u Background-u, inače broj frejmova dekodovanih unapred
 } mp3Decoder_mcv =
 {
 	//default values for mp3DecoderMCV
 0x00000001,				// enable mp3 decoder
 0,						// input wave channel 0,
-NO_SOURCE,				// input wave channel 1,
-1,				        // input wave channel 2,
+1,						// input wave channel 1,
+NO_SOURCE,				// input wave channel 2,
 NO_SOURCE,				// input wave channel 3,
 NO_SOURCE,				// input wave channel 4,
 NO_SOURCE,				// input wave channel 5,
@@ -82,6 +143,7 @@ NO_SOURCE,				// input wave channel 28,
 NO_SOURCE,				// input wave channel 29,
 NO_SOURCE,				// input wave channel 30,
 NO_SOURCE,				// input wave channel 31,
+0,						// decode ahead frames
 };
 
 
@@ -96,15 +158,16 @@ HAOS_Mct_t mp3Decoder_mct =
 	mp3Decoder_AFAPFunction,	// AFAP
 	mp3Decoder_BackgroundFunction,	// Background
 	0,	// Pre-malloc
-	0	// Post-malloc 
+	0,	// Post-malloc
+	0	// MCV changed
 };
 
 HAOS_Mif_t mp3Decoder_mif = { &mp3Decoder_mcv, &mp3Decoder_mct };
 
 HAOS_Odt_t mp3Decoder_odt =
 {
-	{&mp3Decoder_mif, 0x10},
-	{0, 0}
+	{&mp3Decoder_mif, 0x10, "Mp3Decoder"},
+	{0, 0, 0}
 };
 
 HAOS_OdtEntry_t* mp3Decoder_odtPtr = mp3Decoder_odt;
@@ -112,14 +175,15 @@ HAOS_OdtEntry_t* mp3Decoder_odtPtr = mp3Decoder_odt;
 // Definicija frameData strukture
 static HAOS_FrameData_t mp3Decoder_frameData;
 
-// definicija HAOS_CopyToIOPtrs_t strukture za MP3 dekoder
-static HAOS_CopyToIOPtrs_t mp3Decoder_copyToIOPtrs;
-
 
 void __fg_call mp3Decoder_prekickFunction(void* PcmDecoder_mifPtr)
 {
 	std::cout << "start prekick MP3" << std::endl;
 
+	// ulaz je MP3 bitstream: reči u FIFO-u nose bajtove redom od najvišeg bajta,
+	// pa BitRipper čita zaglavlje frejma direktno
+	HAOS::setCompressedInputStream(true);
+
 	std::cout << "end prekick MP3" << std::endl;
 }
 
@@ -142,7 +206,6 @@ void __fg_call mp3Decoder_postkickFunction()
 	// Inicijalizovati frameData i postaviti odgovarajući pokazivač na nju
 	mp3Decoder_frameData.sampleRate = 48000;
 	mp3Decoder_frameData.decodeInfo = DECODE_INFO_MP3;
-	mp3Decoder_copyToIOPtrs.frameData = &mp3Decoder_frameData;
 
 	// Inicijalizovati PingPong pokazivače
 	PingPongSample_buffer_WrPtr[0] = PingPongsample_buffer;
@@ -152,38 +215,258 @@ void __fg_call mp3Decoder_postkickFunction()
 	PingPongSample_buffer_EndPtr[0] = PingPongsample_buffer + MP3_FRAME_SIZE * 2;
 	PingPongSample_buffer_EndPtr[1] = PingPongsample_buffer + MP3_FRAME_SIZE * 2 * 2;
 
+	// sinhroni put predaje cele frejmove brikova, pa brik mora da deli frejm;
+	// dekodovanje unapred puni brikove preko granica frejmova
+	if (mp3Decoder_mcv.mp3Enable && !mp3Decoder_mcv.decodeAheadFrames && (MP3_FRAME_SIZE % BRICK_SIZE) != 0)
+	{
+		std::cerr << "The MP3 decoder needs a brick size that divides " << MP3_FRAME_SIZE
+			<< ", or decode-ahead (decodeAheadFrames, MCV word 33)" << std::endl;
+		exit(1);
+	}
+
 	// pozvati inicijalizaciju mp3 dekodera	
 	mp3 = mp3_create();
 
+	// kraj ulaznog toka je kad dekoder potroši sve frejmove iz FIFO-a, ne kad se pročita kraj fajla
+	if (mp3Decoder_mcv.mp3Enable)
+	{
+		HAOS::holdInputStreamEnd(true);
+	}
+
+	// pokrenuti radnu nit za dekodovanje unapred
+	if (mp3Decoder_mcv.mp3Enable && mp3Decoder_mcv.decodeAheadFrames)
+	{
+		Mp3DecodeAhead_t* pAhead = &mp3Decoder_ahead;
+
+		if (mp3Decoder_mcv.decodeAheadFrames > MP3_DECODE_AHEAD_FRAMES_MAX)
+		{
+			mp3Decoder_mcv.decodeAheadFrames = MP3_DECODE_AHEAD_FRAMES_MAX;
+		}
+
+		BrickRing::init(&pAhead->ring, MP3_PCM_RING_BRICKS);
+		pAhead->aheadBricks = (mp3Decoder_mcv.decodeAheadFrames * MP3_FRAME_SIZE + BRICK_SIZE - 1) / BRICK_SIZE;
+		pAhead->fillCnt = 0;
+		pAhead->finished.store(false);
+		pAhead->enabled = true;
+
+		// kod dekodovanja unapred kraj toka pušta AFAP, kad nit preda poslednji brik
+		pAhead->thread = std::thread(mp3Decoder_decodeAheadThread, HAOS::getActiveCore());
+
+		std::cout << "MP3 decode ahead: " << mp3Decoder_mcv.decodeAheadFrames << " frame(s)" << std::endl;
+	}
+
 	std::cout << "end postkick MP3" << std::endl;
 }
 
+// Layer III bitrate (kbps) po indeksu, za MPEG 1 i za MPEG 2/2.5
+static const uint16_t mp3Decoder_bitrateTab[2][15] =
+{
+	{ 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },
+	{ 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }
+};
+
+static const uint16_t mp3Decoder_sampleRateTab[3] = { 44100, 48000, 32000 };
+
+// Vraća dužinu frejma u bajtovima ako je header ispravno Layer III zaglavlje, inače 0.
+// Free format (bitrate indeks 0) dekoder ne podržava, pa ni to zaglavlje nije ispravno.
+static uint32_t mp3Decoder_frameBytes(uint32_t header)
+{
+	uint32_t bitrateIdx = (header >> 12) & 0xf;
+	uint32_t sampleRateIdx = (header >> 10) & 3;
+
+	if (((header & 0xffe00000) != 0xffe00000) ||	// sinhronizacija
+		((header & (3 << 17)) != (1 << 17)) ||		// Layer III
+		((header & (3 << 19)) == (1 << 19)) ||		// rezervisana verzija
+		(bitrateIdx == 0) || (bitrateIdx == 15) || (sampleRateIdx == 3))
+	{
+		return 0;
+	}
+
+	// MPEG 1: bit 19 = 1; MPEG 2: bit 20 = 1, bit 19 = 0; MPEG 2.5: bit 20 = 0
+	uint32_t lsf = ((header >> 19) & 1) ? 0 : 1;
+	uint32_t mpeg25 = ((header >> 20) & 1) ? 0 : 1;
+	uint32_t sampleRate = mp3Decoder_sampleRateTab[sampleRateIdx] >> (lsf + mpeg25);
+	uint32_t padding = (header >> 9) & 1;
+
+	return (mp3Decoder_bitrateTab[lsf][bitrateIdx] * 144000) / (sampleRate << lsf) + padding;
+}
+
+// Vraća dužinu frejma koji počinje na trenutnoj poziciji BitRipper-a, 0 ako u ovom pozivu nije nađen.
+// Kada je sinhronizacija izgubljena, zaglavlje se traži bajt po bajt i prihvata tek kada i sledeći
+// frejm počinje ispravnim zaglavljem; sledeće zaglavlje se čita unapred, a pozicija se zatim vraća.
+static uint32_t mp3Decoder_findFrame(pBitRipperState_t pBitRipper)
+{
+	uint32_t frameBytes = mp3Decoder_frameBytes(BitRipper::peek(pBitRipper, 32));
+
+	if (mp3Decoder_synced && frameBytes)
+	{
+		return frameBytes;
+	}
+
+	mp3Decoder_synced = false;
+
+	for (uint32_t byte = 0; byte < MP3_RESYNC_BYTES_MAX; byte++)
+	{
+		if (frameBytes)
+		{
+			// skipBits() dopunjava FIFO od pomoćne pozicije, zato ceo frejm i sledeće zaglavlje
+			// moraju biti u FIFO-u pre nego što se pređe na pomoćno stanje
+			BitRipper::waitOnDipstick((frameBytes + 4) * 8);
+
+			BitRipper::saveMainState();
+			BitRipper::skipBits(frameBytes * 8);
+			uint32_t nextFrameBytes = mp3Decoder_frameBytes(BitRipper::peek(pBitRipper, 32));
+			BitRipper::restoreMainState();
+
+			if (nextFrameBytes)
+			{
+				mp3Decoder_synced = true;
+				return frameBytes;
+			}
+		}
+
+		BitRipper::skipBits(8);
+		frameBytes = mp3Decoder_frameBytes(BitRipper::peek(pBitRipper, 32));
+	}
+
+	return 0;
+}
+
+// Pronalazi, čita i dekoduje sledeći frejm u sample_buffer; vraća false ako u ovom pozivu nema PCM-a
+static bool mp3Decoder_decodeFrame(pBitRipperState_t pBitRipper)
+{
+	// pronaći sledeći frejm, neiskorišćeni bajtovi ostaju u FIFO-u
+	uint32_t frameBytes = mp3Decoder_findFrame(pBitRipper);
+	if (frameBytes == 0)
+	{
+		return false;
+	}
+
+	// pročitati tačno jedan frejm iz FIFO-a preko BitRipper-a: cele reči odjednom, pa ostatak po bajt
+	uint32_t wordCnt = frameBytes / 4;
+	BitRipper::extractWords(pBitRipper, bs_words, wordCnt);
+
+	for (uint32_t word = 0; word < wordCnt; word++)
+	{
+		bs_buffer[word * 4 + 0] = (bs_words[word] >> 24) & 0xFF;
+		bs_buffer[word * 4 + 1] = (bs_words[word] >> 16) & 0xFF;
+		bs_buffer[word * 4 + 2] = (bs_words[word] >> 8) & 0xFF;
+		bs_buffer[word * 4 + 3] = (bs_words[word] >> 0) & 0xFF;
+	}
+
+	for (uint32_t byte = wordCnt * 4; byte < frameBytes; byte++)
+	{
+		bs_buffer[byte] = BitRipper::extractBits(pBitRipper, 8);
+	}
+
+	// pozvati dekodovanje mp3 frejma; 0 znači da frejm nije dekodovan
+	// (npr. bit rezervoar pokazuje na podatke pre resinhronizacije)
+	return mp3_decode(mp3, bs_buffer, frameBytes, sample_buffer, &info) != 0;
+}
+
+// Upisuje dekodovani frejm u prsten, brik po brik; čeka dok je u prstenu aheadBricks brikova
+static void mp3Decoder_pushFrame()
+{
+	Mp3DecodeAhead_t* pAhead = &mp3Decoder_ahead;
+	uint32_t ringSize = pAhead->ring.mask + 1;
+	int sample = 0;
+
+	while (sample < MP3_FRAME_SIZE)
+	{
+		while (ringSize - BrickRing::freeCnt(&pAhead->ring) >= pAhead->aheadBricks)
+		{
+			if (pAhead->stop.load(std::memory_order_relaxed))
+			{
+				return;
+			}
+			std::this_thread::yield();
+		}
+
+		Mp3Decoder_RingBrick_t* pBrick = &pAhead->bricks[BrickRing::writeSlot(&pAhead->ring)];
+		int cnt = MP3_FRAME_SIZE - sample;
+		if (cnt > (int)(BRICK_SIZE - pAhead->fillCnt))
+		{
+			cnt = BRICK_SIZE - pAhead->fillCnt;
+		}
+
+		// deinterlivovati odbirke oba kanala
+		for (int i = 0; i < cnt; i++, sample++)
+		{
+			pBrick->data[0][pAhead->fillCnt + i] = (HAOS_PcmSample_t)sample_buffer[2 * sample] / PCM16_SCALE;
+			pBrick->data[1][pAhead->fillCnt + i] = (HAOS_PcmSample_t)sample_buffer[2 * sample + 1] / PCM16_SCALE;
+		}
+
+		pBrick->sampleRate = info.sample_rate;
+		pAhead->fillCnt += cnt;
+
+		// predati pun brik AFAP-u
+		if (pAhead->fillCnt == BRICK_SIZE)
+		{
+			BrickRing::commitWrite(&pAhead->ring);
+			pAhead->fillCnt = 0;
+		}
+	}
+}
+
+// Radna nit: dekoduje frejmove dok ne dođe do kraja toka, na BitRipper-u i FIFO-u jezgra pCore
+static void mp3Decoder_decodeAheadThread(void* pCore)
+{
+	Mp3DecodeAhead_t* pAhead = &mp3Decoder_ahead;
+
+	HAOS::setActiveCore(pCore);
+	pBitRipperState_t pBitRipper = BitRipper::getActiveState();
+
+	while (!pAhead->stop.load(std::memory_order_relaxed))
+	{
+		if (mp3Decoder_decodeFrame(pBitRipper))
+		{
+			mp3Decoder_pushFrame();
+		}
+		else if (!mp3Decoder_synced && HAOS::getInputStreamEOF())
+		{
+			// posle kraja fajla u FIFO-u nema zaglavlja, ostala je samo dopuna
+			break;
+		}
+	}
+
+	// dopuniti poslednji brik nulama
+	if (pAhead->fillCnt && !pAhead->stop.load(std::memory_order_relaxed))
+	{
+		Mp3Decoder_RingBrick_t* pBrick = &pAhead->bricks[BrickRing::writeSlot(&pAhead->ring)];
+		memset(&pBrick->data[0][pAhead->fillCnt], 0, (BRICK_SIZE - pAhead->fillCnt) * sizeof(HAOS_PcmSample_t));
+		memset(&pBrick->data[1][pAhead->fillCnt], 0, (BRICK_SIZE - pAhead->fillCnt) * sizeof(HAOS_PcmSample_t));
+		BrickRing::commitWrite(&pAhead->ring);
+		pAhead->fillCnt = 0;
+	}
+
+	pAhead->finished.store(true, std::memory_order_release);
+}
+
 void __bg_call mp3Decoder_BackgroundFunction()
 {
-	// proveriti da li je mp3 dekoder omogućen, ako nije, ne radi ništa
-	if (mp3Decoder_mcv.mp3Enable)
+	// proveriti da li je mp3 dekoder omogućen, ako nije, ne radi ništa;
+	// kod dekodovanja unapred frejmove dekoduje radna nit
+	if (mp3Decoder_mcv.mp3Enable && !mp3Decoder_ahead.enabled)
 	{
-		// pročitati kompresovane podatke iz FIFO+a preko BitRipper-a
-		for (int sample = 0; sample < MP3_INPUT_CHUNK_SIZE / 4;)
+		if (!mp3Decoder_decodeFrame(BitRipper::getActiveState()))
 		{
-			int word = BitRipper::extractBits(32);
-			bs_buffer[sample * 4 + 0] = (word >> 0) & 0xFF;
-			bs_buffer[sample * 4 + 1] = (word >> 8) & 0xFF;
-			bs_buffer[sample * 4 + 2] = (word >> 16) & 0xFF;
-			bs_buffer[sample * 4 + 3] = (word >> 24) & 0xFF;
-			sample++;
+			// posle kraja fajla u FIFO-u nema zaglavlja, ostala je samo dopuna: pustiti kraj ulaznog toka
+			if (!mp3Decoder_synced && HAOS::getInputStreamEOF())
+			{
+				HAOS::holdInputStreamEnd(false);
+			}
+			return;
 		}
-		// pozvati dekodovanje mp3 frejma
-		int byte_count = mp3_decode(mp3, bs_buffer, MP3_FRAME_SIZE * BUFFER_COUNT * 2, sample_buffer, &info);
-		if (byte_count != 0)
-			PCMAvailable = MP3_FRAME_SIZE;
+
+		PCMAvailable = MP3_FRAME_SIZE;
+		mp3Decoder_frameData.sampleRate = info.sample_rate;
 
 		// kopirati interlivovane uzorke u Ping-Pong bafer (po kanalima) u odgovarajucem formatu
 		for (int ch = 0; ch < 2; ch++)
 		{
 			int i = 0;
 			HAOS_PcmSample_t* wr = PingPongSample_buffer_WrPtr[ch];
-			for (int sample = ch; sample < MP3_FRAME_SIZE * 2 - 1; sample += 2)
+			for (int sample = ch; sample < MP3_FRAME_SIZE * 2; sample += 2)
 			{
 				wr[i++] = (HAOS_PcmSample_t)sample_buffer[sample] / PCM16_SCALE;
 			}
@@ -205,8 +488,59 @@ void __bg_call mp3Decoder_BackgroundFunction()
 // ------------------------------------------------
 // AFAP – slanje PCM-a u IO
 // ------------------------------------------------
+// Preuzima jedan brik iz prstena radne niti (dekodovanje unapred)
+static void mp3Decoder_popBrick()
+{
+	Mp3DecodeAhead_t* pAhead = &mp3Decoder_ahead;
+
+	// brik funkcije se pozivaju i kad dekoder ne preda brik, zato se čeka na nit
+	// dok ne preda sledeći brik ili ne završi
+	while (BrickRing::usedCnt(&pAhead->ring) == 0)
+	{
+		if (pAhead->finished.load(std::memory_order_acquire))
+		{
+			// nit je završila i prsten je prazan: pustiti kraj ulaznog toka
+			if (pAhead->thread.joinable())
+			{
+				pAhead->thread.join();
+				HAOS::holdInputStreamEnd(false);
+			}
+			return;
+		}
+		std::this_thread::yield();
+	}
+
+	Mp3Decoder_RingBrick_t* pBrick = &pAhead->bricks[BrickRing::readSlot(&pAhead->ring)];
+	HAOS_PcmSamplePtr_t* ioBricks = HAOS::acquireInputBricks();
+	int ch = 0;
+
+	// kopirati brik iz prstena u IO bafere aktivnih kanala
+	for (int j = 0, inputChannelMask = mp3Decoder_frameData.inputChannelMask; inputChannelMask != 0; j++, inputChannelMask >>= 1)
+	{
+		if ((inputChannelMask & 1) && (ch < 2))
+		{
+			memcpy(ioBricks[j], pBrick->data[ch++], sizeof(HAOS_BrickBuffer_t));
+		}
+	}
+
+	mp3Decoder_frameData.outputChannelMask = mp3Decoder_frameData.inputChannelMask;
+	mp3Decoder_frameData.sampleRate = pBrick->sampleRate;
+
+	// vratiti slot radnoj niti
+	BrickRing::commitRead(&pAhead->ring);
+
+	HAOS::commitInputBricks(&mp3Decoder_frameData);
+	HAOS::setValidChannelMask(mp3Decoder_frameData.outputChannelMask);
+}
+
 void __fg_call mp3Decoder_AFAPFunction()
 {
+	if (mp3Decoder_ahead.enabled)
+	{
+		mp3Decoder_popBrick();
+		return;
+	}
+
 	// proveriti da li ima dovoljno dostupnih PCM-ova za kopiranje
 	if (PCMAvailable >= BRICK_SIZE)
 	{
@@ -215,15 +549,17 @@ void __fg_call mp3Decoder_AFAPFunction()
 		int j = 0;
 		int ch = 0;
 
+		// uzeti IO brikove u koje se upisuju odbirci
+		HAOS_PcmSamplePtr_t* ioBricks = HAOS::acquireInputBricks();
+
 		{
-			// priprema IO pokazivače po kanalima
+			// kopirati BRICK iz PingPong-a direktno u IO bafere
 			mp3Decoder_frameData.outputChannelMask = mp3Decoder_frameData.inputChannelMask;;
 			while (inputChannelMask != 0)
 			{
 				if (inputChannelMask & 1)
 				{
-					// postaviti odgovarajuće IOBufferPtrs za kopiranje iz PingPong-a u IO bafere
-					mp3Decoder_copyToIOPtrs.IOBufferPtrs[j] = PingPongSample_buffer_RdPtr[ch];
+					memcpy(ioBricks[j], PingPongSample_buffer_RdPtr[ch], sizeof(HAOS_BrickBuffer_t));
 					// ažurirati PingPong pokazivače
 					PingPongSample_buffer_RdPtr[ch] += BRICK_SIZE;
 					ch++;
@@ -243,8 +579,8 @@ void __fg_call mp3Decoder_AFAPFunction()
 			}
 		}
 
-		// kopirati BRICK u IO
-		HAOS::copyBrickToIO(&mp3Decoder_copyToIOPtrs);
+		// predati IO brikove na obradu
+		HAOS::commitInputBricks(&mp3Decoder_frameData);
 
 		// ažurirati validnu kanalnu masku
 		HAOS::setValidChannelMask(mp3Decoder_frameData.outputChannelMask);
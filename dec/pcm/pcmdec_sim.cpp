@@ -12,15 +12,17 @@
 
 #include <iostream>
 #include <string>
+#include <cstring>
 #include "haos_api.h"
 #include "haos.h"
 #include "pcmdec_sim.h"
+#include "pcmdec_simd.h"
 #include "bitripper_sim.h"
 #include "wavefile.h"
 
-static HAOS_PcmSample_t tempSampleBuffer[NUMBER_OF_IO_CHANNELS * BRICK_SIZE];
-static HAOS_PcmSample_t sampleBuffer[NUMBER_OF_IO_CHANNELS * BRICK_SIZE];
-static HAOS_PcmSample_t* rdPtr;  //read pointer of temp input buffer
+static HAOS_BrickBuffer_t discardBrick;  //destination of input channels without an IO channel
+static uint32_t PcmDecoder_words[BRICK_SIZE * NUMBER_OF_IO_CHANNELS];  //interleaved input words of one brick
+static HAOS_PcmSample_t PcmDecoder_sampleScale;  //1 / SAMPLE_SCALE, set by the postkick
 
 struct
 {
@@ -77,21 +79,21 @@ HAOS_Mct_t PcmDecoder_mct =
 	0,	// AFAP
 	0,	// Background
 	PcmDecoder_premallocFunction,	// Pre-malloc
-	0	// Post-malloc 
+	0,	// Post-malloc
+	0	// MCV changed
 };
 
 HAOS_Mif_t PcmDecoder_mif = {&PcmDecoder_mcv, &PcmDecoder_mct};
 
 HAOS_Odt_t PcmDecoder_odt =
 {
-	{&PcmDecoder_mif, 0x10},
-	{0, 0}
+	{&PcmDecoder_mif, 0x10, "PcmDecoder"},
+	{0, 0, 0}
 };
 
 HAOS_OdtEntry_t* PcmDecoder_odtPtr = PcmDecoder_odt;
 
 static HAOS_FrameData_t PcmDecoder_frameData;
-static HAOS_CopyToIOPtrs_t PcmDecoder_copyToIOPtrs;
 
 void __fg_call PcmDecoder_premallocFunction()
 {
@@ -122,68 +124,57 @@ void __fg_call PcmDecoder_postkickFunction()
 	}
 	PcmDecoder_frameData.sampleRate = HAOS::getInputStreamFS();
 	PcmDecoder_frameData.decodeInfo = DECODE_INFO_PCM;
-	PcmDecoder_copyToIOPtrs.frameData = &PcmDecoder_frameData;
+	PcmDecoder_sampleScale = 1 / SAMPLE_SCALE;
 
 	std::cout << "end postkick PCM" << std::endl;
 }
 
 void __fg_call PcmDecoder_brickFunction()
 {
-	//1. extract bits from FIFO0 to temp buffers
-	//2. copy buffers to IO
-	//3. repeat process
-	int inputChannelMask;
-	int i = 0;
-	int j = 0;
-	int sample = 0;
+	//1. get the IO bricks of the next brick
+	//2. extract bits from FIFO0 and deinterleave them straight to the IO bricks
+	//3. hand the IO bricks over, repeat process
 	uint32_t nInputChannels = HAOS::getInputStreamChCnt();
-
-	int loopSize = BRICK_SIZE * nInputChannels;
+	HAOS_PcmSamplePtr_t dstBricks[NUMBER_OF_IO_CHANNELS];
 
 	if (PcmDecoder_mcv.pcmEnable)
 	{
 		if(!HAOS::getInputStreamEOF())
 		{
-			for(sample = 0; sample < BRICK_SIZE * nInputChannels;)
+			HAOS_PcmSamplePtr_t* ioBricks = HAOS::acquireInputBricks();
+			uint32_t inCh = 0;
+
+			//input channel n goes to the n-th channel of the input channel mask,
+			//channels of the mask without an input channel are cleared
+			for (HAOS_ChannelMask_t chMask = PcmDecoder_frameData.inputChannelMask; chMask != 0; chMask &= chMask - 1)
 			{
-				for (int ch = 0; ch < nInputChannels; ch++)
+				HAOS_PcmSamplePtr_t ioBrick = ioBricks[HAOS_lowestChannel(chMask)];
+
+				if (inCh < nInputChannels)
 				{
-					tempSampleBuffer[sample] = BitRipper::extractBits(32) / SAMPLE_SCALE;
-					sample++;
+					dstBricks[inCh++] = ioBrick;
 				}
-			}
-
-			//copy interleaved samples to individual channels
-			for (int ch = 0; ch < nInputChannels; ch++)
-			{
-				for (int sample = ch; sample < loopSize; sample += nInputChannels)
+				else
 				{
-					sampleBuffer[i] = tempSampleBuffer[sample];
-					i++;
+					memset(ioBrick, 0, sizeof(HAOS_BrickBuffer_t));
 				}
 			}
 
-			//set read pointer
-			rdPtr = sampleBuffer;
-			inputChannelMask = PcmDecoder_frameData.inputChannelMask;
+			//input channels without an IO channel are extracted and dropped
+			for (; inCh < nInputChannels; inCh++)
 			{
-				PcmDecoder_frameData.outputChannelMask = PcmDecoder_frameData.inputChannelMask;;
-				while (inputChannelMask != 0)
-				{
-					if (inputChannelMask & 1)
-					{
-						PcmDecoder_copyToIOPtrs.IOBufferPtrs[j] = rdPtr;
-						rdPtr+=BRICK_SIZE;
-					}
-					j++;
-					inputChannelMask = inputChannelMask >> 1;
-				}
+				dstBricks[inCh] = discardBrick;
 			}
 
+			//one brick of interleaved words in one go, scaled and deinterleaved by the kernel
+			BitRipper::extractWords(PcmDecoder_words, BRICK_SIZE * nInputChannels);
+			PcmDecoder_getDeinterleave(nInputChannels)(PcmDecoder_words, nInputChannels, dstBricks, PcmDecoder_sampleScale);
+
+			PcmDecoder_frameData.outputChannelMask = PcmDecoder_frameData.inputChannelMask;
 			PcmDecoder_frameData.sampleRate = HAOS::getInputStreamFS();
 
-			//copy Brick to IO
-			HAOS::copyBrickToIO(&PcmDecoder_copyToIOPtrs);
+			//hand the IO bricks over
+			HAOS::commitInputBricks(&PcmDecoder_frameData);
 			HAOS::setValidChannelMask(PcmDecoder_frameData.outputChannelMask);
 		}
 	}
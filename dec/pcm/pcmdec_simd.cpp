@@ -0,0 +1,186 @@
+/////////////////////////////////////////////////////////
+// pcmdec_simd.cpp
+//
+//	Deinterleave kernels of the PCM decoder, see pcmdec_simd.h.
+//	The kernels are templates on the channel count: 1, 2, 6 and 8
+//	channels are instantiated with a constant count, 0 stands for any
+//	other count (read from nChannels).
+/////////////////////////////////////////////////////////
+
+#include "pcmdec_simd.h"
+
+#if PCMDEC_SIMD && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define PCMDEC_SIMD_X86 1
+#include <emmintrin.h>
+#else
+#define PCMDEC_SIMD_X86 0
+#endif
+
+//==============================================================================
+// Scalar reference kernel
+//==============================================================================
+
+template <uint32_t N>
+static void deinterleaveScalar(const uint32_t* words, uint32_t nChannels, HAOS_PcmSamplePtr_t* dstBricks, HAOS_PcmSample_t scale)
+{
+	const uint32_t chCnt = N ? N : nChannels;
+
+	for (int sample = 0; sample < BRICK_SIZE; sample++, words += chCnt)
+	{
+		for (uint32_t ch = 0; ch < chCnt; ch++)
+		{
+			dstBricks[ch][sample] = (HAOS_PcmSample_t)(int32_t)words[ch] * scale;
+		}
+	}
+}
+
+//==============================================================================
+// SSE2 kernel (baseline on x86)
+//
+// A pass takes the words of LANES consecutive samples. Each channel pair is
+// loaded as one 64-bit word per sample and the pairs are interleaved with
+// unpack shuffles, so one register holds a channel's LANES samples. The 32-bit
+// integers are converted to samples and scaled in the register.
+//==============================================================================
+
+#if PCMDEC_SIMD_X86
+
+#if HAOS_PCM_FLOAT32
+
+#define LANES	4
+
+// Channel ch of the LANES samples starting at words, rows of chCnt words
+static inline __m128i loadChannel(const uint32_t* words, uint32_t chCnt, uint32_t ch)
+{
+	return _mm_setr_epi32(words[ch], words[chCnt + ch], words[2 * chCnt + ch], words[3 * chCnt + ch]);
+}
+
+// Channels ch and ch + 1 of the LANES samples starting at words
+static inline void loadChannelPair(const uint32_t* words, uint32_t chCnt, uint32_t ch, __m128i* first, __m128i* second)
+{
+	__m128i row0 = _mm_loadl_epi64((const __m128i*)&words[ch]);
+	__m128i row1 = _mm_loadl_epi64((const __m128i*)&words[chCnt + ch]);
+	__m128i row2 = _mm_loadl_epi64((const __m128i*)&words[2 * chCnt + ch]);
+	__m128i row3 = _mm_loadl_epi64((const __m128i*)&words[3 * chCnt + ch]);
+
+	// ch s0, ch s1, ch+1 s0, ch+1 s1 and ch s2, ch s3, ch+1 s2, ch+1 s3
+	__m128i low = _mm_unpacklo_epi32(row0, row1);
+	__m128i high = _mm_unpacklo_epi32(row2, row3);
+
+	*first = _mm_unpacklo_epi64(low, high);
+	*second = _mm_unpackhi_epi64(low, high);
+}
+
+static inline void storeChannel(HAOS_PcmSample_t* dst, __m128i words, __m128 scale)
+{
+	_mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(words), scale));
+}
+
+static inline __m128 setScale(HAOS_PcmSample_t scale)
+{
+	return _mm_set1_ps(scale);
+}
+
+#else
+
+#define LANES	2
+
+static inline __m128i loadChannel(const uint32_t* words, uint32_t chCnt, uint32_t ch)
+{
+	return _mm_unpacklo_epi32(_mm_cvtsi32_si128(words[ch]), _mm_cvtsi32_si128(words[chCnt + ch]));
+}
+
+static inline void loadChannelPair(const uint32_t* words, uint32_t chCnt, uint32_t ch, __m128i* first, __m128i* second)
+{
+	__m128i row0 = _mm_loadl_epi64((const __m128i*)&words[ch]);
+	__m128i row1 = _mm_loadl_epi64((const __m128i*)&words[chCnt + ch]);
+
+	// ch s0, ch s1, ch+1 s0, ch+1 s1
+	*first = _mm_unpacklo_epi32(row0, row1);
+	*second = _mm_unpackhi_epi64(*first, *first);
+}
+
+static inline void storeChannel(HAOS_PcmSample_t* dst, __m128i words, __m128d scale)
+{
+	_mm_storeu_pd(dst, _mm_mul_pd(_mm_cvtepi32_pd(words), scale));
+}
+
+static inline __m128d setScale(HAOS_PcmSample_t scale)
+{
+	return _mm_set1_pd(scale);
+}
+
+#endif
+
+#if (BRICK_SIZE % LANES) != 0
+#error "The PCM decoder kernels require BRICK_SIZE to be a multiple of the SSE2 vector width"
+#endif
+
+template <uint32_t N>
+static void deinterleaveSse2(const uint32_t* words, uint32_t nChannels, HAOS_PcmSamplePtr_t* dstBricks, HAOS_PcmSample_t scale)
+{
+	const uint32_t chCnt = N ? N : nChannels;
+	const auto vScale = setScale(scale);
+
+	if (chCnt == 1)
+	{
+		// mono words are already in sample order
+		for (int sample = 0; sample < BRICK_SIZE; sample += LANES)
+		{
+			storeChannel(&dstBricks[0][sample], LANES == 4 ? _mm_loadu_si128((const __m128i*)&words[sample]) :
+				_mm_loadl_epi64((const __m128i*)&words[sample]), vScale);
+		}
+		return;
+	}
+
+	for (int sample = 0; sample < BRICK_SIZE; sample += LANES, words += LANES * chCnt)
+	{
+		uint32_t ch = 0;
+
+		for (; ch + 1 < chCnt; ch += 2)
+		{
+			__m128i first, second;
+
+			loadChannelPair(words, chCnt, ch, &first, &second);
+			storeChannel(&dstBricks[ch][sample], first, vScale);
+			storeChannel(&dstBricks[ch + 1][sample], second, vScale);
+		}
+
+		if (ch < chCnt)
+		{
+			storeChannel(&dstBricks[ch][sample], loadChannel(words, chCnt, ch), vScale);
+		}
+	}
+}
+
+#endif // PCMDEC_SIMD_X86
+
+//==============================================================================
+
+PcmDecoder_Deinterleave_t PcmDecoder_getScalarDeinterleave(uint32_t nChannels)
+{
+	switch (nChannels)
+	{
+	case 1: return deinterleaveScalar<1>;
+	case 2: return deinterleaveScalar<2>;
+	case 6: return deinterleaveScalar<6>;
+	case 8: return deinterleaveScalar<8>;
+	default: return deinterleaveScalar<0>;
+	}
+}
+
+PcmDecoder_Deinterleave_t PcmDecoder_getDeinterleave(uint32_t nChannels)
+{
+#if PCMDEC_SIMD_X86
+	switch (nChannels)
+	{
+	case 1: return deinterleaveSse2<1>;
+	case 2: return deinterleaveSse2<2>;
+	case 6: return deinterleaveSse2<6>;
+	case 8: return deinterleaveSse2<8>;
+	default: return deinterleaveSse2<0>;
+	}
+#else
+	return PcmDecoder_getScalarDeinterleave(nChannels);
+#endif
+}
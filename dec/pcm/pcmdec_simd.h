@@ -0,0 +1,33 @@
+/////////////////////////////////////////////////////////
+// pcmdec_simd.h
+//
+//	Deinterleave kernels of the PCM decoder. A kernel takes one brick of
+//	interleaved 32-bit PCM words, as extracted from the input FIFO, scales
+//	them to samples and writes them to one brick per input channel.
+/////////////////////////////////////////////////////////
+
+#ifndef __PCM_DECODER_SIMD_H__
+#define __PCM_DECODER_SIMD_H__
+
+#include <stdint.h>
+#include "haos_api.h"
+
+// Set PCMDEC_SIMD to 0 to always use the scalar reference kernels
+#ifndef PCMDEC_SIMD
+#define PCMDEC_SIMD 1
+#endif
+
+// @brief Scales and deinterleaves one brick of PCM words.
+//
+// dstBricks[ch][s] = (int32_t)words[s * nChannels + ch] * scale, for s = 0 .. BRICK_SIZE - 1.
+// scale is a power of 2 (1 / SAMPLE_SCALE), so the result is the same as dividing by SAMPLE_SCALE.
+typedef void (*PcmDecoder_Deinterleave_t)(const uint32_t* words, uint32_t nChannels,
+	HAOS_PcmSamplePtr_t* dstBricks, HAOS_PcmSample_t scale);
+
+// Returns the kernel for nChannels interleaved channels; 1, 2, 6 and 8 channels have their own
+PcmDecoder_Deinterleave_t PcmDecoder_getDeinterleave(uint32_t nChannels);
+
+// Returns the scalar reference kernel for nChannels interleaved channels
+PcmDecoder_Deinterleave_t PcmDecoder_getScalarDeinterleave(uint32_t nChannels);
+
+#endif /* __PCM_DECODER_SIMD_H__ */
@@ -9,20 +9,25 @@
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <cstddef>
 #include "am_sim.h"
 #include "haos.h"
 #include "haos_api.h"
+#include "haos_ramp.h"
 #include "wavefile.h"
 #include <stdint.h>
 
-struct
+typedef struct
 {
 	HAOS_PcmSample_t	gain;
 	bool				mute;
 	HAOS_PcmSample_t	channelTrim[NUMBER_OF_IO_CHANNELS];
 	int32_t				channelRemap[NUMBER_OF_IO_CHANNELS];
-	int32_t				reserved[32];
-} AudioManager_mcv=
+	int32_t				rampLength;		// gain changes are ramped over this many samples, 0 switches them at once
+	int32_t				reserved[31];
+} AudioManager_Mcv_t;
+
+AudioManager_Mcv_t AudioManager_mcv=
 {
 	1,	 // gain - 0.5
 	0,		// mute - 0 - not muted, 1 - muted
@@ -89,7 +94,8 @@ struct
 	NO_SOURCE,           	// IOBUFFER[28] --> output wave channel 28
 	NO_SOURCE,            	// IOBUFFER[29] --> output wave channel 29
 	NO_SOURCE,            	// IOBUFFER[30] --> output wave channel 30
-	NO_SOURCE            	// IOBUFFER[31] --> output wave channel 31
+	NO_SOURCE,            	// IOBUFFER[31] --> output wave channel 31
+	HAOS_RAMP_LENGTH_DFLT	// rampLength
 };
 
 HAOS_Mct_t AudioManager_mct =
@@ -102,87 +108,156 @@ HAOS_Mct_t AudioManager_mct =
 	0,	// AFAP
 	0,	// Background
 	0,	// Pre-malloc
-	0	// Post-malloc
+	0,	// Post-malloc
+	AudioManager_mcvChanged	// MCV changed
 };
 
 HAOS_Mif_t AudioManager_mif = {&AudioManager_mcv, &AudioManager_mct};
 
 HAOS_Odt_t AudioManager_odt =
 {
-	{&AudioManager_mif, 0x60},
-	{0,0} // null entry terminates the table of modules
+	{&AudioManager_mif, 0x60, "AudioManager"},
+	{0, 0, 0} // null entry terminates the table of modules
 };
 
 HAOS_OdtEntry_t* AudioManager_odtPtr = AudioManager_odt;
 
-void __fg_call AudioManager_brickFunction()
+// Effective gain of each channel (gain, mute and trim), ramped to the value
+// computed by AudioManager_combineGainMuteAndTrims()
+static HAOS_GainRamp_t AudioManager_channelGain;
+
+// Channels with a remap entry, they are output even without input
+static HAOS_ChannelMask_t AudioManager_remapMask;
+
+// Set by the first brick, the MCV changes before it are applied by AudioManager_combineGainMuteAndTrims()
+static bool AudioManager_gainsValid = false;
+
+static uint32_t AudioManager_rampLength()
 {
+	return AudioManager_mcv.rampLength > 0 ? AudioManager_mcv.rampLength : 0;
+}
 
-	HAOS_ChannelMask_t validChannelMask = HAOS::getValidChannelMask();
-	HAOS_ChannelMask_t outputChannelMask = HAOS::getValidChannelMask();
-	int32_t samplesToWrite = BRICK_SIZE;
-	int32_t channel = 0;
-	int32_t inpCh = 0;
-	int32_t currChannel = 0;
-	HAOS_PcmSamplePtr_t* ioTablePtr = HAOS::getIOChannelPointerTable();
-	HAOS_BrickBuffer_t temporaryBricks[NUMBER_OF_IO_CHANNELS];
+static void AudioManager_updateChannel(int ch)
+{
+	HAOS_PcmSample_t globalGain = AudioManager_mcv.gain * !AudioManager_mcv.mute;
+
+	GainRamp::setTarget(&AudioManager_channelGain, ch, globalGain * AudioManager_mcv.channelTrim[ch]);
+}
+
+static void AudioManager_updateRemap(int ch)
+{
+	if (AudioManager_mcv.channelRemap[ch] != NO_SOURCE)
+	{
+		AudioManager_remapMask |= 1U << ch;
+	}
+	else
+	{
+		AudioManager_remapMask &= ~(1U << ch);
+	}
+}
+
+void AudioManager_combineGainMuteAndTrims()
+{
+	// the initial gains are applied at once, later changes are ramped
+	GainRamp::init(&AudioManager_channelGain, 0, 1);
+
+	AudioManager_remapMask = 0;
+
+	for (int ch = 0; ch < NUMBER_OF_IO_CHANNELS; ch++)
+	{
+		AudioManager_updateChannel(ch);
+		AudioManager_updateRemap(ch);
+	}
+
+	GainRamp::setRampLength(&AudioManager_channelGain, AudioManager_rampLength());
+
+	AudioManager_gainsValid = true;
+}
+
+void __fg_call AudioManager_mcvChanged(uint32_t offset, uint32_t wordCnt)
+{
+	const uint32_t mcvWords = sizeof(AudioManager_Mcv_t) / sizeof(uint32_t);
+
+	if (!AudioManager_gainsValid || offset >= mcvWords)
+	{
+		return;
+	}
 
-	memset(temporaryBricks, 0, NUMBER_OF_IO_CHANNELS * sizeof(HAOS_BrickBuffer_t));
+	uint32_t end = wordCnt < mcvWords - offset ? offset + wordCnt : mcvWords;
+	HAOS_ChannelMask_t trimMask = 0;
+	HAOS_ChannelMask_t remapMask = 0;
+	bool globalChanged = false;
 
-	// apply gain, trim and mute and write the result to TEMPBUFFERs
-	for (int ioCh = 0; ioCh < NUMBER_OF_IO_CHANNELS; ioCh++)
+	// find the changed fields from the byte offsets of the written words (MCV field order)
+	for (uint32_t word = offset; word < end; word++)
 	{
-		HAOS_PcmSamplePtr_t ioChData = ioTablePtr[ioCh];
-		HAOS_PcmSample_t globalGain = AudioManager_mcv.gain * !AudioManager_mcv.mute;
+		size_t byte = word * sizeof(uint32_t);
 
-		if (HAOS::isActiveChannel(ioCh))
+		if (byte < offsetof(AudioManager_Mcv_t, channelTrim))
 		{
-			HAOS_PcmSample_t channelVolumeTrim = AudioManager_mcv.channelTrim[ioCh];
-			HAOS_PcmSample_t* tempSample = temporaryBricks[ioCh];
-
-			for (int sample = 0; sample < BRICK_SIZE; sample++)
-			{
-				if (globalGain * channelVolumeTrim == 1.0)
-					*tempSample++ = ioChData[sample];
-				else
-					*tempSample++ = (globalGain * channelVolumeTrim * ioChData[sample]);
-				
-				// Data processed into temporary buffer, no need to have the original value anymore
-				ioChData[sample] = 0;
-			}
+			globalChanged = true;	// gain or mute
 		}
-
-		//refresh channels mask based on AudioManager MCV
-		if (AudioManager_mcv.channelRemap[ioCh] != NO_SOURCE)
+		else if (byte < offsetof(AudioManager_Mcv_t, channelRemap))
+		{
+			trimMask |= 1U << ((byte - offsetof(AudioManager_Mcv_t, channelTrim)) / sizeof(HAOS_PcmSample_t));
+		}
+		else if (byte < offsetof(AudioManager_Mcv_t, rampLength))
 		{
-			outputChannelMask |= 1 << ioCh;
+			remapMask |= 1U << ((byte - offsetof(AudioManager_Mcv_t, channelRemap)) / sizeof(int32_t));
+		}
+		else if (byte < offsetof(AudioManager_Mcv_t, reserved))
+		{
+			GainRamp::setRampLength(&AudioManager_channelGain, AudioManager_rampLength());
 		}
 	}
 
-	HAOS::setValidChannelMask(outputChannelMask);
+	// gain and mute change all channels, a trim only its own
+	for (HAOS_ChannelMask_t chMask = globalChanged ? ALL_BITS_SET : trimMask; chMask != 0; chMask &= chMask - 1)
+	{
+		AudioManager_updateChannel(HAOS_lowestChannel(chMask));
+	}
 
-	channel = 0;
-	int ch = 0;
-	// apply remap, move samples to IOBUFFERs
-	while (outputChannelMask != 0)
+	for (HAOS_ChannelMask_t chMask = remapMask; chMask != 0; chMask &= chMask - 1)
 	{
-		if (outputChannelMask & 1)
+		AudioManager_updateRemap(HAOS_lowestChannel(chMask));
+	}
+}
+
+void __fg_call AudioManager_brickFunction()
+{
+	HAOS_PcmSamplePtr_t* ioTablePtr = HAOS::getIOChannelPointerTable();
+
+	// later MCV changes are applied by AudioManager_mcvChanged()
+	if (!AudioManager_gainsValid)
+	{
+		AudioManager_combineGainMuteAndTrims();
+	}
+
+	HAOS_ChannelMask_t activeChannelMask = HAOS::getValidChannelMask();
+	HAOS_ChannelMask_t outputChannelMask = activeChannelMask | AudioManager_remapMask;
+	int32_t outCh = 0;
+
+	// apply gain, trim and mute and move the output channels to IOBUFFER[0 .. n-1] in one pass;
+	// output channel n comes from channel n or above, so it's done in place in ascending order
+	for (HAOS_ChannelMask_t chMask = outputChannelMask; chMask != 0; chMask &= chMask - 1, outCh++)
+	{
+		int32_t ch = HAOS_lowestChannel(chMask);
+		HAOS_PcmSamplePtr_t srcData = ioTablePtr[ch];
+		HAOS_PcmSamplePtr_t dstData = ioTablePtr[outCh];
+
+		if (!(activeChannelMask & (1U << ch)))
 		{
-			int ioCh = AudioManager_mcv.channelRemap[channel];
-			HAOS_PcmSamplePtr_t ioChData = ioTablePtr[ch];
-			for (int sample = 0; sample < samplesToWrite; sample++)
-			{
-				ioChData[sample] = temporaryBricks[channel][sample];
-			}
-			ch++;
+			// remapped channel without input
+			memset(dstData, 0, sizeof(HAOS_BrickBuffer_t));
+		}
+		else
+		{
+			// copied if the gain is 1, scaled or ramped otherwise
+			GainRamp::apply(&AudioManager_channelGain, ch, srcData, dstData);
 		}
-		channel++;
-		outputChannelMask >>= 1;
 	}
 
-	/*if(!(HAOS::getFrameCounter() % 1000))
-	{
-		std::cout << AudioManager_mcv.gain << "\n";
-	}*/
+	// the output channels are packed from channel 0, the others are silent now
+	HAOS::setValidChannelMask(outCh < NUMBER_OF_IO_CHANNELS ? (1U << outCh) - 1 : ALL_BITS_SET);
 }
 //==============================================================================
@@ -9,9 +9,12 @@
 #ifndef __AM_SIM_H__
 #define __AM_SIM_H__
 
+#include <stdint.h>
+
 #define __fg_call
 
 void AudioManager_combineGainMuteAndTrims();
 void __fg_call AudioManager_brickFunction();
+void __fg_call AudioManager_mcvChanged(uint32_t offset, uint32_t wordCnt);
 
 #endif /* __AM_SIM_H__ */
@@ -1,6 +1,9 @@
 #include "fx.h"
+#include "fx_simd.h"
 #include "haos_api.h"
+#include "haos_ramp.h"
 #include <string.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <algorithm>
@@ -16,20 +19,37 @@
 // Get sample rate from HaOS
 #define SAMPLE_RATE HAOS::getInputStreamFS()
 
+// Debug logging, muted when haOS renders offline
+#define FX_DEBUG(...) do { if (!HAOS::getOfflineMode()) printf(__VA_ARGS__); } while (0)
+
 static FX_ControlPanel moduleControl;
 
+// Output gain of each channel, ramped to the control panel value (see updateOutputGains)
+static HAOS_GainRamp_t outputGain;
+static bool outputGainValid = false;
+
+// Brick kernels (scalar reference or SIMD), selected in FX_init
+static const FX_Kernels* kernels = FX_getScalarKernels();
+
 #define NTAPS 31 
 #define DBUFSIZE 640
 #define MAX_DELAY_SAMPLES 24000  // for 450ms @ 48kHz + margin
 
+// All LPF tables are symmetric (linear phase), so the FIR can fold the delay line
+// and do half of the multiplies. Folding changes the rounding of the sum, so it is
+// disabled by default to stay bit-exact with the reference output.
+#ifndef FX_FIR_SYMMETRIC
+#define FX_FIR_SYMMETRIC 0
+#endif
+
 // Gain values in linear scale
-static const double GAIN_CH0_PRE = 0.81283;    // -1.8 dB
-static const double GAIN_CH0_POST = 0.87096;   // -1.2 dB
-static const double GAIN_CH1_PRE = 0.79433;    // -2.0 dB
-static const double GAIN_CH1_POST = 0.77426;   // -2.2 dB
+static const FX_Sample_t GAIN_CH0_PRE = FX_toSample(0.81283);    // -1.8 dB
+static const FX_Sample_t GAIN_CH0_POST = FX_toSample(0.87096);   // -1.2 dB
+static const FX_Sample_t GAIN_CH1_PRE = FX_toSample(0.79433);    // -2.0 dB
+static const FX_Sample_t GAIN_CH1_POST = FX_toSample(0.77426);   // -2.2 dB
 
 // Filter coefficients for CH1-CH5 (for cutoff 2k, 3k, 4k, 5k)
-static double lpf2kHz_coeffs[NTAPS] =
+static const double lpf2kHz_coeffs[NTAPS] =
 {
     -0.00293477270045858870,
     -0.00288096430204124940,
@@ -64,7 +84,7 @@ static double lpf2kHz_coeffs[NTAPS] =
     -0.00293477270045858870
 };
 
-static double lpf3kHz_coeffs[NTAPS] =
+static const double lpf3kHz_coeffs[NTAPS] =
 {
     -0.00105106340607596220,
     -0.00170346888080965400,
@@ -99,7 +119,7 @@ static double lpf3kHz_coeffs[NTAPS] =
     -0.00105106340607596220
 };
 
-static double lpf4kHz_coeffs[NTAPS] =
+static const double lpf4kHz_coeffs[NTAPS] =
 {
     0.00023788185274493161,
     0.00014732315999688281,
@@ -134,7 +154,7 @@ static double lpf4kHz_coeffs[NTAPS] =
     0.00023788185274493161
 };
 
-static double lpf5kHz_coeffs[NTAPS] =
+static const double lpf5kHz_coeffs[NTAPS] =
 {
     0.00008857651266302499,
     0.00018563654770944524,
@@ -169,174 +189,263 @@ static double lpf5kHz_coeffs[NTAPS] =
     0.00008857651266302499
 };
 
-// Filter history buffers for all channels
-static double filter_history[6][NTAPS];
+// Filter coefficients in the FX sample type (converted from the tables above in FX_init)
+static FX_Sample_t filter_coeffs[4][NTAPS];
+
+// Length of the FIR delay line: NTAPS - 1 samples of history plus one brick of new input
+#define FIR_LINE_SIZE (NTAPS - 1 + BLOCK_SIZE)
 
-// FIR implementation
-static double fir(double input, double* coeffs, double* history, unsigned int ntaps)
+// FIR state for one channel.
+// The delay line is kept twice (mirrored), so the newest FIR_LINE_SIZE samples are always
+// contiguous in memory and the delay line never has to be shifted.
+typedef struct
+{
+    FX_Sample_t line[2 * FIR_LINE_SIZE];
+    int head;
+} FirState;
+
+// Number of distinct CH1 filters and CH0 delays (see FX_ControlPanel)
+#define NUM_FILTERS 4
+#define NUM_DELAYS 4
+
+// Processing paths shared between channels, built from the control panel in FX_init.
+// Every channel reads the same two inputs, so channels with the same filter (or delay)
+// setting compute the same samples: each distinct filter and delay runs once per brick
+// and its output is used by all channels that select it.
+typedef struct
 {
-    int i;
-    double ret = 0;
+    int filterCnt;
+    FX_Sample_t* filterCoeffs[NUM_FILTERS];
+    int channelFilter[6];       // filter path used by each channel
 
-    // Shift delay line
-    for (i = ntaps - 2; i >= 0; i--)
-    {
-        history[i + 1] = history[i];
-    }
+    int channelDelay[6];        // delay tap used by each channel, -1 for gain only CH0
+} FxPaths;
+
+static FxPaths paths;
+
+// Filter states, one per filter path
+static FirState filter_state[NUM_FILTERS];
 
-    // Store input at the beginning of the delay line
-    history[0] = input;
+static void firInit(FirState* state)
+{
+    memset(state->line, 0, sizeof(state->line));
+    state->head = 0;
+}
 
-    // FIR calculation
-    for (i = 0; i < ntaps; i++)
+// Block FIR implementation, filters one brick per call.
+// Input and output may point to the same buffer.
+static void firBlock(const FX_Sample_t* input, FX_Sample_t* output, const FX_Sample_t* coeffs, FirState* state)
+{
+    FX_Sample_t* line = state->line;
+    int head = state->head;
+
+    // Store the new samples at the head of the delay line and at its mirror
+    for (int s = 0; s < BLOCK_SIZE; s++)
     {
-        ret += coeffs[i] * history[i];
+        line[head] = input[s];
+        line[head + FIR_LINE_SIZE] = input[s];
+        if (++head == FIR_LINE_SIZE)
+        {
+            head = 0;
+        }
     }
-
-    return ret;
+    state->head = head;
+
+    // x[s] is the s-th new sample, x[s - i] the sample i taps before it
+    const FX_Sample_t* x = &line[head + FIR_LINE_SIZE - BLOCK_SIZE];
+
+#if FX_FIR_SYMMETRIC
+    // Linear phase filters: fold the delay line around the centre tap
+    kernels->firSymmetric(x, coeffs, NTAPS, output);
+#else
+    // Every output keeps the summation order of the reference FIR (bit-exact)
+    kernels->fir(x, coeffs, NTAPS, output);
+#endif
 }
 
-// Delay state structure
+// Length of the CH0 delay line. The extra brick lets a whole brick be written before
+// the taps are read, even for the longest delay.
+#define DELAY_LINE_SIZE (MAX_DELAY_SAMPLES + BLOCK_SIZE)
+
+// CH0 delay line shared by all channels.
+// Every channel delays the same pre-gained CH0 signal, so the signal is stored once
+// (one write position) and each distinct delay is a read tap at a fixed distance behind it.
 typedef struct
 {
-    double* delayBuffer;
-    double* bufferEndPointer;
-    double* readPointer;
-    double* writePointer;
-    int delay;
-    int bufferSize;
-} DelayState;
-
-// Delay buffers for each channel
-static DelayState channel_delay_state[6];
-static double channel_delay_buffer[6][MAX_DELAY_SAMPLES];
+    FX_Sample_t line[DELAY_LINE_SIZE];
+    int writeIndex;
+    int tapCnt;
+    int tapDelay[NUM_DELAYS];
+} DelayLine;
+
+static DelayLine ch0_delay;
+
+// Delay in samples for each ch0_delay_select value, computed in initCH0Delays
+static int delay_samples_table[4];
 
 // Delay implementation
-static void delayInit(DelayState* delayState, double* delayBuffer, int delayBufLen, int delay)
+static void delayInit(DelayLine* delayLine)
 {
-    printf("DEBUG delayInit: Starting, delayBufLen=%d, delay=%d\n", delayBufLen, delay);
+    FX_DEBUG("DEBUG delayInit: Starting, line size=%d\n", DELAY_LINE_SIZE);
 
-    if (!delayBuffer) {
-        printf("ERROR delayInit: delayBuffer is NULL!\n");
-        return;
-    }
+    delayLine->writeIndex = 0;
+    delayLine->tapCnt = 0;
 
-    delayState->delayBuffer = delayBuffer;
-    delayState->bufferEndPointer = delayState->delayBuffer + delayBufLen;
-    delayState->writePointer = delayState->delayBuffer;
-    delayState->delay = delay;
-    delayState->bufferSize = delayBufLen;
-
-    printf("DEBUG delayInit: Basic pointers set\n");
+    // Initialize buffer to 0
+    memset(delayLine->line, 0, sizeof(delayLine->line));
 
-    // Set read pointer back by delay samples
-    delayState->readPointer = delayState->writePointer - delay;
+    FX_DEBUG("DEBUG delayInit: Finished\n");
+}
 
-    // If readPointer is below buffer start, wrap around
-    if (delayState->readPointer < delayState->delayBuffer) {
-        printf("DEBUG delayInit: Wrapping read pointer\n");
-        delayState->readPointer += delayBufLen;
+// Returns the tap for the given delay, adding a new tap if no existing one matches
+static int delayAddTap(DelayLine* delayLine, int delay)
+{
+    for (int t = 0; t < delayLine->tapCnt; t++) {
+        if (delayLine->tapDelay[t] == delay) {
+            return t;
+        }
     }
 
-    printf("DEBUG delayInit: Read pointer = %p, Write pointer = %p\n",
-        delayState->readPointer, delayState->writePointer);
-
-    // Initialize buffer to 0
-    printf("DEBUG delayInit: Initializing buffer to 0\n");
-    for (int i = 0; i < delayBufLen; i++) {
-        delayBuffer[i] = 0.0;
+    if (delayLine->tapCnt >= NUM_DELAYS) {
+        printf("ERROR delayAddTap: Too many taps!\n");
+        return -1;
     }
 
-    printf("DEBUG delayInit: Finished\n");
+    delayLine->tapDelay[delayLine->tapCnt] = delay;
+    return delayLine->tapCnt++;
 }
 
-static double applyDelay(double input, DelayState* delayState)
+// Removes the taps no channel reads any more, the last tap takes the place of a removed one
+static void delayRemoveUnusedTaps(DelayLine* delayLine, int channelTap[])
 {
+    for (int t = delayLine->tapCnt - 1; t >= 0; t--) {
+        bool used = false;
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            used |= (channelTap[ch] == t);
+        }
+        if (used) {
+            continue;
+        }
 
-    if (!delayState) {
-        printf("ERROR applyDelay: delayState is NULL!\n");
-        return input;
-    }
-
-    if (!delayState->delayBuffer || !delayState->writePointer || !delayState->readPointer) {
-        printf("ERROR applyDelay: Invalid delay state pointers!\n");
-        printf("  delayBuffer: %p\n", delayState->delayBuffer);
-        printf("  writePointer: %p\n", delayState->writePointer);
-        printf("  readPointer: %p\n", delayState->readPointer);
-        return input;
+        int last = --delayLine->tapCnt;
+        delayLine->tapDelay[t] = delayLine->tapDelay[last];
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            if (channelTap[ch] == last) channelTap[ch] = t;
+        }
     }
+}
 
-    if (!delayState->delayBuffer) return input;
+// Writes one brick to the delay line and reads it back at every tap.
+// output[t][i] = input delayed by tapDelay[t] samples (a delay of 0 returns the input).
+static void applyDelay(const FX_Sample_t* input, DelayLine* delayLine, FX_Sample_t output[][BLOCK_SIZE])
+{
+    int start = delayLine->writeIndex;
 
     // Write to buffer
-    *delayState->writePointer = input;
-    delayState->writePointer++;
-
-    // Wrap write pointer
-    if (delayState->writePointer >= delayState->bufferEndPointer) {
-        delayState->writePointer = delayState->delayBuffer;
+    int pos = start;
+    for (int32_t i = 0; i < BLOCK_SIZE; i++) {
+        delayLine->line[pos] = input[i];
+        if (++pos >= DELAY_LINE_SIZE) pos = 0;
     }
+    delayLine->writeIndex = pos;
 
-    // Read from buffer
-    double ret = *delayState->readPointer;
-    delayState->readPointer++;
+    // Read from buffer, each tap trails the write position by its delay
+    for (int t = 0; t < delayLine->tapCnt; t++) {
+        pos = start - delayLine->tapDelay[t];
+        if (pos < 0) pos += DELAY_LINE_SIZE;
 
-    // Wrap read pointer
-    if (delayState->readPointer >= delayState->bufferEndPointer) {
-        delayState->readPointer = delayState->delayBuffer;
+        for (int32_t i = 0; i < BLOCK_SIZE; i++) {
+            output[t][i] = delayLine->line[pos];
+            if (++pos >= DELAY_LINE_SIZE) pos = 0;
+        }
     }
+}
 
-    return ret;
+// Function to get coefficients based on selector
+static FX_Sample_t* getFilterCoeffs(int filter_select)
+{
+    switch (filter_select) {
+    case 0: return filter_coeffs[0];
+    case 1: return filter_coeffs[1];
+    case 2: return filter_coeffs[2];
+    case 3: return filter_coeffs[3];
+    default: return filter_coeffs[2];
+    }
 }
 
-// Add limiter function
-static double add(double input0, double input1)
+// Convert the LPF tables to the FX sample type
+static void initFilterCoeffs()
 {
-    double ret = input0 + input1;
-    if (ret >= 1.0) ret = 0.99999999;
-    if (ret < -1.0) ret = -1.0;
-    return ret;
+    const double* tables[4] = { lpf2kHz_coeffs, lpf3kHz_coeffs, lpf4kHz_coeffs, lpf5kHz_coeffs };
+
+    for (int f = 0; f < 4; f++) {
+        for (int i = 0; i < NTAPS; i++) {
+            filter_coeffs[f][i] = FX_toSample(tables[f][i]);
+        }
+    }
 }
 
-// Function to get coefficients based on selector
-static double* getFilterCoeffs(int filter_select)
+// Map every enabled channel to a filter path, one path per distinct filter
+static void initCH1Filters()
 {
-    switch (filter_select) {
-    case 0: return lpf2kHz_coeffs;
-    case 1: return lpf3kHz_coeffs;
-    case 2: return lpf4kHz_coeffs;
-    case 3: return lpf5kHz_coeffs;
-    default: return lpf4kHz_coeffs;
+    paths.filterCnt = 0;
+
+    for (int ch = 0; ch < 6; ch++) {
+        paths.channelFilter[ch] = -1;
+
+        if (!moduleControl.channel_enable[ch]) {
+            continue;
+        }
+
+        FX_Sample_t* coeffs = getFilterCoeffs(moduleControl.ch1_filter_select[ch]);
+
+        int f = 0;
+        while (f < paths.filterCnt && paths.filterCoeffs[f] != coeffs) {
+            f++;
+        }
+        if (f == paths.filterCnt) {
+            paths.filterCoeffs[paths.filterCnt++] = coeffs;
+        }
+        paths.channelFilter[ch] = f;
     }
+
+    FX_DEBUG("DEBUG initCH1Filters: %d distinct filter(s)\n", paths.filterCnt);
 }
 
-// Initialize delays for all channels
+// Initialize the CH0 delay line, one tap per distinct delay
 static void initCH0Delays()
 {
-    printf("DEBUG initCH0Delays: Starting\n");
+    FX_DEBUG("DEBUG initCH0Delays: Starting\n");
 
     int sample_rate = SAMPLE_RATE;
     if (sample_rate == 0) sample_rate = 48000; // default
 
-    printf("DEBUG initCH0Delays: Sample rate = %d\n", sample_rate);
+    FX_DEBUG("DEBUG initCH0Delays: Sample rate = %d\n", sample_rate);
 
-    const int delay_samples_table[4] = {
-        0,                      // 0ms
-        (int)(sample_rate * 0.150),   // 150ms
-        (int)(sample_rate * 0.300),   // 300ms
-        (int)(sample_rate * 0.450)    // 450ms
-    };
+    delay_samples_table[0] = 0;                             // 0ms
+    delay_samples_table[1] = (int)(sample_rate * 0.150);    // 150ms
+    delay_samples_table[2] = (int)(sample_rate * 0.300);    // 300ms
+    delay_samples_table[3] = (int)(sample_rate * 0.450);    // 450ms
 
-    printf("DEBUG initCH0Delays: Delay table = [%d, %d, %d, %d]\n",
+    FX_DEBUG("DEBUG initCH0Delays: Delay table = [%d, %d, %d, %d]\n",
         delay_samples_table[0], delay_samples_table[1],
         delay_samples_table[2], delay_samples_table[3]);
 
+    delayInit(&ch0_delay);
+
     for (int ch = 0; ch < 6; ch++) {
-        printf("DEBUG initCH0Delays: Processing channel %d\n", ch);
+        FX_DEBUG("DEBUG initCH0Delays: Processing channel %d\n", ch);
+
+        paths.channelDelay[ch] = -1;
 
         // Check if channel is enabled
         if (!moduleControl.channel_enable[ch]) {
-            printf("DEBUG initCH0Delays: Channel %d disabled, skipping\n", ch);
+            FX_DEBUG("DEBUG initCH0Delays: Channel %d disabled, skipping\n", ch);
+            continue;
+        }
+
+        // Gain only channels don't use a delay
+        if (!moduleControl.ch0_processing[ch]) {
             continue;
         }
 
@@ -346,11 +455,11 @@ static void initCH0Delays()
             delay_select = 0; // default to 0ms if invalid
         }
 
-        printf("DEBUG initCH0Delays: Channel %d delay_select = %d\n", ch, delay_select);
+        FX_DEBUG("DEBUG initCH0Delays: Channel %d delay_select = %d\n", ch, delay_select);
 
         int delay_samples = delay_samples_table[delay_select];
 
-        printf("DEBUG initCH0Delays: Channel %d delay_samples = %d\n", ch, delay_samples);
+        FX_DEBUG("DEBUG initCH0Delays: Channel %d delay_samples = %d\n", ch, delay_samples);
 
         //dodato
         if (delay_samples >= MAX_DELAY_SAMPLES) {
@@ -358,48 +467,204 @@ static void initCH0Delays()
             printf("Warning: Delay for channel %d clamped to %d samples\n", ch, delay_samples);
         }
 
-        printf("DEBUG initCH0Delays: Initializing delay for channel %d\n", ch);
+        // Channels with the same delay share a tap
+        paths.channelDelay[ch] = delayAddTap(&ch0_delay, delay_samples);
+
+        FX_DEBUG("DEBUG initCH0Delays: Channel %d uses delay tap %d\n", ch, paths.channelDelay[ch]);
+    }
+
+    FX_DEBUG("DEBUG initCH0Delays: Finished\n");
+}
+
+// Re-route the CH0 path of one channel after its controls have changed
+static void updateCH0Delay(int ch)
+{
+    paths.channelDelay[ch] = -1;
+    delayRemoveUnusedTaps(&ch0_delay, paths.channelDelay);
+
+    if (!moduleControl.channel_enable[ch] || !moduleControl.ch0_processing[ch]) {
+        return;
+    }
+
+    int delay_select = moduleControl.ch0_delay_select[ch];
+    if (delay_select < 0 || delay_select > 3) {
+        delay_select = 0; // default to 0ms if invalid
+    }
+    int delay_samples = std::min(delay_samples_table[delay_select], MAX_DELAY_SAMPLES - 1);
+
+    // The line isn't written while it has no taps, the samples in it are stale
+    if (ch0_delay.tapCnt == 0) {
+        memset(ch0_delay.line, 0, sizeof(ch0_delay.line));
+    }
+
+    // A new tap reads the history already in the line, no other channel is disturbed
+    paths.channelDelay[ch] = delayAddTap(&ch0_delay, delay_samples);
+}
+
+// Remove the filter paths no channel uses any more, the last path takes the place of a removed one
+static void removeUnusedFilters()
+{
+    for (int f = paths.filterCnt - 1; f >= 0; f--) {
+        bool used = false;
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            used |= (paths.channelFilter[ch] == f);
+        }
+        if (used) {
+            continue;
+        }
+
+        int last = --paths.filterCnt;
+        paths.filterCoeffs[f] = paths.filterCoeffs[last];
+        filter_state[f] = filter_state[last];
+        for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+            if (paths.channelFilter[ch] == last) paths.channelFilter[ch] = f;
+        }
+    }
+}
+
+// Re-route the CH1 path of one channel after its controls have changed
+static void updateCH1Filter(int ch)
+{
+    paths.channelFilter[ch] = -1;
+    removeUnusedFilters();
+
+    if (!moduleControl.channel_enable[ch]) {
+        return;
+    }
+
+    FX_Sample_t* coeffs = getFilterCoeffs(moduleControl.ch1_filter_select[ch]);
+
+    int f = 0;
+    while (f < paths.filterCnt && paths.filterCoeffs[f] != coeffs) {
+        f++;
+    }
+    if (f == paths.filterCnt) {
+        // All filters see the same input, a new one takes over the history of another
+        if (f > 0) {
+            filter_state[f] = filter_state[0];
+        }
+        else {
+            firInit(&filter_state[f]);
+        }
+        paths.filterCoeffs[paths.filterCnt++] = coeffs;
+    }
+    paths.channelFilter[ch] = f;
+}
 
-        // Initialize delay for this channel
-        delayInit(&channel_delay_state[ch], channel_delay_buffer[ch],
-            MAX_DELAY_SAMPLES, delay_samples);
+// Ramp the output gains to the control panel values, the gains of the first block are set at once
+static void updateOutputGains()
+{
+    if (!outputGainValid) {
+        GainRamp::init(&outputGain, 0, 1);
+    }
 
-        printf("DEBUG initCH0Delays: Channel %d delay initialized\n", ch);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        GainRamp::setTarget(&outputGain, ch, (HAOS_PcmSample_t)moduleControl.output_gain[ch]);
     }
+    GainRamp::setRampLength(&outputGain, moduleControl.ramp_length);
 
-    printf("DEBUG initCH0Delays: Finished\n");
+    outputGainValid = true;
 }
 // FX implementation
 void FX_init(FX_ControlPanel* controlsInit)
 {
-    printf("DEBUG FX_init: Starting initialization\n");
+    FX_DEBUG("DEBUG FX_init: Starting initialization\n");
 
     // Copy controls
     memcpy(&moduleControl, controlsInit, sizeof(FX_ControlPanel));
 
-    printf("DEBUG FX_init: Controls copied, initializing delays...\n");
+    FX_DEBUG("DEBUG FX_init: Controls copied, initializing delays...\n");
 
     // Initialize delays for all channels
     initCH0Delays();
 
-    printf("DEBUG FX_init: Delays initialized, resetting filter history...\n");
+    FX_DEBUG("DEBUG FX_init: Delays initialized, resetting filter history...\n");
+
+    // Map channels to filters and reset filter history
+    initFilterCoeffs();
+    initCH1Filters();
+    for (int f = 0; f < NUM_FILTERS; f++) {
+        firInit(&filter_state[f]);
+    }
+
+    // The output gains are set by the first block (the host may still change them)
+    outputGainValid = false;
 
-    // Reset filter history
-    memset(filter_history, 0, sizeof(filter_history));
+    // Pick the brick kernels for this CPU
+    kernels = FX_getKernels();
+    FX_DEBUG("DEBUG FX_init: Using %s kernels\n", kernels->name);
 
-    printf("DEBUG FX_init: Initialization complete\n");
+    FX_DEBUG("DEBUG FX_init: Initialization complete\n");
+}
+
+// Apply the words [offset, offset + wordCnt) of controls (32-bit words of FX_ControlPanel).
+// Only the paths of the channels whose controls are in the range are re-routed.
+void FX_updateControls(const FX_ControlPanel* controls, uint32_t offset, uint32_t wordCnt)
+{
+    const uint32_t panelWords = sizeof(FX_ControlPanel) / sizeof(uint32_t);
+    if (offset >= panelWords) return;
+    uint32_t end = (wordCnt < panelWords - offset) ? offset + wordCnt : panelWords;
+
+    memcpy((uint32_t*)&moduleControl + offset, (const uint32_t*)controls + offset, (end - offset) * sizeof(uint32_t));
+
+    uint32_t delayChannels = 0;
+    uint32_t filterChannels = 0;
+    bool gainsChanged = false;
+
+    // Find the changed channels from the byte offsets of the words (FX_ControlPanel field order)
+    for (uint32_t word = offset; word < end; word++) {
+        size_t byte = word * sizeof(uint32_t);
+
+        if (byte < offsetof(FX_ControlPanel, channel_enable)) {
+            continue;   // on, checked every block
+        }
+        else if (byte < offsetof(FX_ControlPanel, ch0_delay_select)) {
+            int ch = (int)((byte - offsetof(FX_ControlPanel, channel_enable)) / sizeof(uint32_t));
+            delayChannels |= 1U << ch;
+            filterChannels |= 1U << ch;
+        }
+        else if (byte < offsetof(FX_ControlPanel, ch0_processing)) {
+            delayChannels |= 1U << ((byte - offsetof(FX_ControlPanel, ch0_delay_select)) / sizeof(uint32_t));
+        }
+        else if (byte < offsetof(FX_ControlPanel, ch1_filter_select)) {
+            delayChannels |= 1U << ((byte - offsetof(FX_ControlPanel, ch0_processing)) / sizeof(uint32_t));
+        }
+        else if (byte < offsetof(FX_ControlPanel, ramp_length)) {
+            filterChannels |= 1U << ((byte - offsetof(FX_ControlPanel, ch1_filter_select)) / sizeof(uint32_t));
+        }
+        else {
+            gainsChanged = true;
+        }
+    }
+
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        if (delayChannels & (1U << ch)) updateCH0Delay(ch);
+        if (filterChannels & (1U << ch)) updateCH1Filter(ch);
+    }
+
+    // Before the first block the gains are still set at once by FX_processBlock
+    if (gainsChanged && outputGainValid) {
+        updateOutputGains();
+    }
+
+    FX_DEBUG("DEBUG FX_updateControls: words %u..%u, %d delay tap(s), %d filter(s)\n",
+        offset, end - 1, ch0_delay.tapCnt, paths.filterCnt);
 }
 
 void FX_processBlock()
 {
     if (!moduleControl.on) return;
 
+    if (!outputGainValid) {
+        updateOutputGains();
+    }
+
     // Get actual number of input channels
     int input_channels = HAOS::getInputStreamChCnt();  // This should be 2
 
     // DEBUG: Add this to see what's happening
     static int debug_counter = 0;
-    if (debug_counter++ < 5) {
+    if (!HAOS::getOfflineMode() && debug_counter++ < 5) {
         printf("FX_processBlock: input_channels = %d\n", input_channels);
         printf("FX_processBlock: sampleBuffer pointer = %p\n", sampleBuffer);
         if (sampleBuffer) {
@@ -408,56 +673,56 @@ void FX_processBlock()
         }
     }
 
+    FX_Sample_t ch0_input[BLOCK_SIZE];
+    FX_Sample_t ch1_input[BLOCK_SIZE];
+    FX_Sample_t ch0_pre[BLOCK_SIZE];
+    FX_Sample_t ch1_pre[BLOCK_SIZE];
+    FX_Sample_t filtered_ch1[NUM_FILTERS][BLOCK_SIZE];
+    FX_Sample_t delayed_ch0[NUM_DELAYS][BLOCK_SIZE];
+
+    // FIXED: ALWAYS use input channels 0 and 1 for ALL FX channels
+    // Only check if input channels actually exist
+    // Inputs are latched once, before any output overwrites them (in-place processing)
     for (int32_t i = 0; i < BLOCK_SIZE; i++) {
-        // Process all 6 channels
-        for (int ch = 0; ch < 6; ch++) {
-            if (!moduleControl.channel_enable[ch]) continue;
-
-            // FIXED: ALWAYS use input channels 0 and 1 for ALL FX channels
-            // Only check if input channels actually exist
-            double ch0_input = 0.0;
-            double ch1_input = 0.0;
-
-            if (input_channels >= 1) {
-                ch0_input = sampleBuffer[0][i];  // Always from input channel 0
-            }
-            if (input_channels >= 2) {
-                ch1_input = sampleBuffer[1][i];  // Always from input channel 1
-            }
-
-            // Process CH0 for this channel
-            double processed_ch0;
-            if (moduleControl.ch0_processing[ch]) {
-                // Complete processing: -1.8dB -> delay -> -1.2dB
-                processed_ch0 = ch0_input * GAIN_CH0_PRE;
-                processed_ch0 = applyDelay(processed_ch0, &channel_delay_state[ch]);
-                processed_ch0 = processed_ch0 * GAIN_CH0_POST;
-            }
-            else {
-                // Gain only: -1.8dB
-                processed_ch0 = ch0_input * GAIN_CH0_PRE;
-            }
-
-            // Process CH1 for this channel: -2.0dB -> filter -> -2.2dB
-            double processed_ch1 = ch1_input * GAIN_CH1_PRE;
-
-            // Apply filter to CH1 (if there's input)
-            if (input_channels >= 2) {
-                int filter_select = moduleControl.ch1_filter_select[ch];
-                double* coeffs = getFilterCoeffs(filter_select);
-                processed_ch1 = fir(processed_ch1, coeffs, filter_history[ch], NTAPS);
-            }
-
-            processed_ch1 = processed_ch1 * GAIN_CH1_POST;
-
-            // SUM: processed CH1 + processed CH0
-            sampleBuffer[ch][i] = add(processed_ch1, processed_ch0);
-
-            // DEBUG: Check for NaN/inf
-            if (processed_ch0 != processed_ch0 || processed_ch1 != processed_ch1) {  // NaN check
-                printf("ERROR: NaN detected at ch=%d, i=%d\n", ch, i);
-                return;
-            }
+        ch0_input[i] = (input_channels >= 1) ? FX_toSample(sampleBuffer[0][i]) : 0;  // Always from input channel 0
+        ch1_input[i] = (input_channels >= 2) ? FX_toSample(sampleBuffer[1][i]) : 0;  // Always from input channel 1
+    }
+
+    // Pre gains are the same for all channels: CH0 -1.8dB, CH1 -2.0dB
+    kernels->scale(ch0_input, GAIN_CH0_PRE, ch0_pre);
+    kernels->scale(ch1_input, GAIN_CH1_PRE, ch1_pre);
+
+    // Run each distinct CH1 filter once (if there's input)
+    if (input_channels >= 2) {
+        for (int f = 0; f < paths.filterCnt; f++) {
+            firBlock(ch1_pre, filtered_ch1[f], paths.filterCoeffs[f], &filter_state[f]);
+        }
+    }
+
+    // Run each distinct CH0 delay once: delay -> -1.2dB
+    if (ch0_delay.tapCnt > 0) {
+        applyDelay(ch0_pre, &ch0_delay, delayed_ch0);
+        for (int t = 0; t < ch0_delay.tapCnt; t++) {
+            kernels->scale(delayed_ch0[t], GAIN_CH0_POST, delayed_ch0[t]);
+        }
+    }
+
+    // Fan the shared paths out to all 6 channels
+    for (int ch = 0; ch < 6; ch++) {
+        if (!moduleControl.channel_enable[ch]) continue;
+
+        // CH1: -2.0dB -> filter -> -2.2dB (post gain applied in the mix)
+        const FX_Sample_t* processed_ch1 = (input_channels >= 2) ? filtered_ch1[paths.channelFilter[ch]] : ch1_pre;
+
+        // CH0: complete processing (-1.8dB -> delay -> -1.2dB) or gain only (-1.8dB)
+        const FX_Sample_t* processed_ch0 = (paths.channelDelay[ch] >= 0) ? delayed_ch0[paths.channelDelay[ch]] : ch0_pre;
+
+        // SUM: processed CH1 (-2.2dB) + processed CH0, with limiter
+        kernels->mixLimit(processed_ch1, GAIN_CH1_POST, processed_ch0, sampleBuffer[ch]);
+
+        // Output gain, nothing to do at 0 dB
+        if (!GainRamp::isUnity(&outputGain, ch)) {
+            GainRamp::apply(&outputGain, ch, sampleBuffer[ch], sampleBuffer[ch]);
         }
     }
 }
@@ -476,18 +741,20 @@ FX_ControlPanel FX_parseArguments(int argc, char* argv[])
         config.ch0_delay_select[i] = 0;        // 0ms delay for all
         config.ch0_processing[i] = 1;          // complete processing for all
         config.ch1_filter_select[i] = 2;       // 4kHz for all
+        config.output_gain[i] = 1.0f;          // 0 dB for all
     }
+    config.ramp_length = HAOS_RAMP_LENGTH_DFLT;
 
     return config;
 }
 
 void check_memory_sizes()
 {
-    std::cout << "Size of channel_delay_buffer: " << sizeof(channel_delay_buffer) << " bytes" << std::endl;
-    std::cout << "Size of filter_history: " << sizeof(filter_history) << " bytes" << std::endl;
-    std::cout << "Size of lpf coeffs: " << sizeof(lpf2kHz_coeffs) * 4 << " bytes" << std::endl;
+    std::cout << "Size of ch0_delay: " << sizeof(ch0_delay) << " bytes" << std::endl;
+    std::cout << "Size of filter_state: " << sizeof(filter_state) << " bytes" << std::endl;
+    std::cout << "Size of lpf coeffs: " << sizeof(filter_coeffs) << " bytes" << std::endl;
     std::cout << "TOTAL STATIC MEMORY: " <<
-        sizeof(channel_delay_buffer) +
-        sizeof(filter_history) +
-        (sizeof(lpf2kHz_coeffs) * 4) << " bytes" << std::endl;
+        sizeof(ch0_delay) +
+        sizeof(filter_state) +
+        sizeof(filter_coeffs) << " bytes" << std::endl;
 }
\ No newline at end of file
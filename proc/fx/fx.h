@@ -13,10 +13,15 @@ typedef struct
     uint32_t ch0_processing[6];      // CH0 processing: 0: samo gain, 1: kompletan
     uint32_t ch1_filter_select[6];   // filter za CH1: 0: 2kHz, 1: 3kHz, 2: 4kHz, 3: 5kHz
 
+    // Izlazni gain, host ga moze menjati tokom rada (primenjuje se od sledeceg brick-a)
+    uint32_t ramp_length;            // promena gain-a traje ramp_length odbiraka, 0: odmah
+    float output_gain[6];            // izlazni gain za svaki kanal (linearno, 1.0 = 0 dB)
+
 } FX_ControlPanel;
 
 void FX_init(FX_ControlPanel* controlsInit);
 void FX_processBlock();
+void FX_updateControls(const FX_ControlPanel* controls, uint32_t offset, uint32_t wordCnt);
 FX_ControlPanel FX_parseArguments(int argc, char* argv[]);
 
 #endif
\ No newline at end of file
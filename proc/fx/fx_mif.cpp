@@ -1,5 +1,6 @@
 ﻿#include "fx.h"
 #include "haos_api.h"
+#include "haos_ramp.h"
 #include <iostream>
 #include <string.h>
 
@@ -18,22 +19,19 @@ static FX_ControlPanel fxMCV = {
     {0, 1, 1, 0, 1, 0},  // gain, full, full, gain, full, gain
 
     // ch1_filter_select[6]  
-    {2, 0, 1, 2, 3, 0}   // 4kHz, 2kHz, 3kHz, 4kHz, 5kHz, 2kHz
-};
+    {2, 0, 1, 2, 3, 0},  // 4kHz, 2kHz, 3kHz, 4kHz, 5kHz, 2kHz
 
-// Globalna promenljiva za FX modul (originalni FX_ControlPanel)
-static FX_ControlPanel moduleControlForHaOS;
+    // ramp_length
+    HAOS_RAMP_LENGTH_DFLT,
 
-// Konverziona funkcija: MCV -> FX_ControlPanel
-static void convertMCVtoFXControlPanel()
-{
-    moduleControlForHaOS = fxMCV;
-}
+    // output_gain[6]
+    {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f}  // 0 dB na svim kanalima
+};
 
 // Callback funkcije za FX modul
 void __fg_call FX_preKick(void* mif);
 void __fg_call FX_processBrick();
-void __bg_call FX_background();
+void __fg_call FX_mcvChanged(uint32_t offset, uint32_t wordCnt);
 
 // MCT (Module Call Table) za FX modul
 HAOS_Mct_t fxMCT = {
@@ -43,9 +41,10 @@ HAOS_Mct_t fxMCT = {
     0,               // Frame
     FX_processBrick, // Brick - glavna processing funkcija
     0,               // AFAP
-    FX_background,   // Background
+    0,               // Background
     0,               // Post-malloc
-    0                // Pre-malloc
+    0,               // Pre-malloc
+    FX_mcvChanged    // MCV changed - host je promenio kontrole
 };
 
 // MIF (Module Interface) struktura
@@ -110,19 +109,11 @@ void __fg_call FX_processBrick()
     HAOS::setValidChannelMask(mask);
 }
 
-// Background callback - može se koristiti za dinamičko update-ovanje kontrola
-void __bg_call FX_background()
+// MCV changed callback - haOS javlja koje reci MCV-a je host upisao,
+// FX menja samo delay tapove, filtre i gain-ove kanala cije su se kontrole promenile
+void __fg_call FX_mcvChanged(uint32_t offset, uint32_t wordCnt)
 {
-    // Ova funkcija može biti prazna ili se može koristiti za
-    // dinamičko update-ovanje kontrola tokom runtime-a
-    static int counter = 0;
-    counter++;
-
-    // Primer: Svakih 1000 poziva proveri da li treba ažurirati konfiguraciju
-    if (counter % 1000 == 0) {
-        // Ažuriraj FX_ControlPanel iz MCV (ako je MCV promenjen od strane hosta)
-        convertMCVtoFXControlPanel();
-    }
+    FX_updateControls(&fxMCV, offset, wordCnt);
 }
 
 
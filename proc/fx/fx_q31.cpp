@@ -0,0 +1,103 @@
+#include "fx_simd.h"
+
+// Q31 (1.31 fixed point) kernels, the arithmetic of the target DSP cores
+#if FX_Q31
+
+#define Q31_MAX INT32_MAX
+#define Q31_MIN INT32_MIN
+
+// Rounding applied when a Q62 product/accumulator is brought back to Q31
+#define Q62_ROUND ((int64_t)1 << 30)
+
+static inline int32_t saturate(int64_t x)
+{
+    if (x > Q31_MAX) return Q31_MAX;
+    if (x < Q31_MIN) return Q31_MIN;
+    return (int32_t)x;
+}
+
+// Q31 x Q31 -> Q31 with rounding (only -1.0 * -1.0 saturates)
+static inline int32_t mulQ31(int32_t a, int32_t b)
+{
+    return saturate(((int64_t)a * b + Q62_ROUND) >> 31);
+}
+
+static void scaleQ31(const FX_Sample_t* input, FX_Sample_t gain, FX_Sample_t* output)
+{
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        output[s] = mulQ31(input[s], gain);
+    }
+}
+
+// Products are summed in a 64-bit Q62 accumulator and rounded once at the end.
+// The LPF tables have a sum of absolute coeffs below 2.0, so the accumulator can't overflow.
+static void firQ31(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output)
+{
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        int64_t acc = 0;
+        for (int i = 0; i < ntaps; i++)
+        {
+            acc += (int64_t)coeffs[i] * x[s - i];
+        }
+        output[s] = saturate((acc + Q62_ROUND) >> 31);
+    }
+}
+
+static void firSymmetricQ31(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output)
+{
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        int64_t acc = 0;
+        for (int i = 0; i < ntaps / 2; i++)
+        {
+            acc += (int64_t)coeffs[i] * ((int64_t)x[s - i] + x[s - (ntaps - 1 - i)]);
+        }
+        if (ntaps & 1)
+        {
+            acc += (int64_t)coeffs[ntaps / 2] * x[s - ntaps / 2];
+        }
+        output[s] = saturate((acc + Q62_ROUND) >> 31);
+    }
+}
+
+// The saturating add is the limiter: Q31 covers exactly [-1.0, 1.0)
+static void mixLimitQ31(const FX_Sample_t* ch1, FX_Sample_t gain1, const FX_Sample_t* ch0, HAOS_PcmSample_t* output)
+{
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        int32_t ret = saturate((int64_t)mulQ31(ch1[s], gain1) + ch0[s]);
+        output[s] = (HAOS_PcmSample_t)ret / (HAOS_PcmSample_t)2147483648.0;
+    }
+}
+
+static const FX_Kernels q31Kernels =
+{
+    "Q31",
+    scaleQ31,
+    firQ31,
+    firSymmetricQ31,
+    mixLimitQ31
+};
+
+//==============================================================================
+
+const FX_Kernels* FX_getScalarKernels()
+{
+    return &q31Kernels;
+}
+
+const FX_Kernels* FX_getKernels()
+{
+    return &q31Kernels;
+}
+
+const FX_Kernels* const* FX_getKernelSets()
+{
+    static const FX_Kernels* sets[] = { &q31Kernels, nullptr };
+
+    return sets;
+}
+
+#endif // FX_Q31
@@ -0,0 +1,457 @@
+#include "fx_simd.h"
+
+// Floating point kernels; the Q31 kernels are in fx_q31.cpp
+#if !FX_Q31
+
+#if FX_SIMD && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define FX_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define FX_SIMD_X86 0
+#endif
+
+// Upper and lower limit of the FX output (see add() in fx.cpp).
+// In float the top limit is the largest value below 1.0 (0.99999999 would round up to 1.0).
+#if HAOS_PCM_FLOAT32
+#define LIMIT_TOP    0.99999994f
+#define LIMIT_BOTTOM -1.0f
+#else
+#define LIMIT_TOP    0.99999999
+#define LIMIT_BOTTOM -1.0
+#endif
+
+//==============================================================================
+// Scalar reference kernels
+//==============================================================================
+
+static void scaleScalar(const FX_Sample_t* input, FX_Sample_t gain, FX_Sample_t* output)
+{
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        output[s] = input[s] * gain;
+    }
+}
+
+static void firScalar(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output)
+{
+    FX_Sample_t acc[BRICK_SIZE];
+
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        acc[s] = 0;
+    }
+
+    for (int i = 0; i < ntaps; i++)
+    {
+        for (int s = 0; s < BRICK_SIZE; s++)
+        {
+            acc[s] += coeffs[i] * x[s - i];
+        }
+    }
+
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        output[s] = acc[s];
+    }
+}
+
+static void firSymmetricScalar(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output)
+{
+    FX_Sample_t acc[BRICK_SIZE];
+
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        acc[s] = 0;
+    }
+
+    for (int i = 0; i < ntaps / 2; i++)
+    {
+        for (int s = 0; s < BRICK_SIZE; s++)
+        {
+            acc[s] += coeffs[i] * (x[s - i] + x[s - (ntaps - 1 - i)]);
+        }
+    }
+
+    if (ntaps & 1)
+    {
+        for (int s = 0; s < BRICK_SIZE; s++)
+        {
+            acc[s] += coeffs[ntaps / 2] * x[s - ntaps / 2];
+        }
+    }
+
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        output[s] = acc[s];
+    }
+}
+
+static void mixLimitScalar(const FX_Sample_t* ch1, FX_Sample_t gain1, const FX_Sample_t* ch0, HAOS_PcmSample_t* output)
+{
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        FX_Sample_t ret = ch1[s] * gain1 + ch0[s];
+        if (ret >= 1) ret = LIMIT_TOP;
+        if (ret < -1) ret = LIMIT_BOTTOM;
+        output[s] = ret;
+    }
+}
+
+static const FX_Kernels scalarKernels =
+{
+    "scalar",
+    scaleScalar,
+    firScalar,
+    firSymmetricScalar,
+    mixLimitScalar
+};
+
+#if FX_SIMD_X86
+
+//==============================================================================
+// Vector types and operations for the sample type: 2 doubles / 4 floats per SSE2
+// register, 4 doubles / 8 floats per AVX2 register.
+//==============================================================================
+
+#if HAOS_PCM_FLOAT32
+typedef __m128 sse2_t;
+#define SSE2_LANES          4
+#define sse2_load           _mm_loadu_ps
+#define sse2_store          _mm_storeu_ps
+#define sse2_set1           _mm_set1_ps
+#define sse2_zero           _mm_setzero_ps
+#define sse2_add            _mm_add_ps
+#define sse2_mul            _mm_mul_ps
+#define sse2_cmpge          _mm_cmpge_ps
+#define sse2_cmplt          _mm_cmplt_ps
+#define sse2_and            _mm_and_ps
+#define sse2_andnot         _mm_andnot_ps
+#define sse2_or             _mm_or_ps
+
+typedef __m256 avx2_t;
+#define AVX2_LANES          8
+#define avx2_load           _mm256_loadu_ps
+#define avx2_store          _mm256_storeu_ps
+#define avx2_set1           _mm256_set1_ps
+#define avx2_broadcast      _mm256_broadcast_ss
+#define avx2_zero           _mm256_setzero_ps
+#define avx2_add            _mm256_add_ps
+#define avx2_mul            _mm256_mul_ps
+#define avx2_cmp            _mm256_cmp_ps
+#define avx2_blendv         _mm256_blendv_ps
+#else
+typedef __m128d sse2_t;
+#define SSE2_LANES          2
+#define sse2_load           _mm_loadu_pd
+#define sse2_store          _mm_storeu_pd
+#define sse2_set1           _mm_set1_pd
+#define sse2_zero           _mm_setzero_pd
+#define sse2_add            _mm_add_pd
+#define sse2_mul            _mm_mul_pd
+#define sse2_cmpge          _mm_cmpge_pd
+#define sse2_cmplt          _mm_cmplt_pd
+#define sse2_and            _mm_and_pd
+#define sse2_andnot         _mm_andnot_pd
+#define sse2_or             _mm_or_pd
+
+typedef __m256d avx2_t;
+#define AVX2_LANES          4
+#define avx2_load           _mm256_loadu_pd
+#define avx2_store          _mm256_storeu_pd
+#define avx2_set1           _mm256_set1_pd
+#define avx2_broadcast      _mm256_broadcast_sd
+#define avx2_zero           _mm256_setzero_pd
+#define avx2_add            _mm256_add_pd
+#define avx2_mul            _mm256_mul_pd
+#define avx2_cmp            _mm256_cmp_pd
+#define avx2_blendv         _mm256_blendv_pd
+#endif
+
+#if (BRICK_SIZE % AVX2_LANES) != 0
+#error "FX SIMD kernels require BRICK_SIZE to be a multiple of the AVX2 vector width"
+#endif
+
+//==============================================================================
+// SSE2 kernels (baseline on x86)
+//==============================================================================
+
+#define SSE2_VECS (BRICK_SIZE / SSE2_LANES)
+
+static void scaleSse2(const FX_Sample_t* input, FX_Sample_t gain, FX_Sample_t* output)
+{
+    sse2_t g = sse2_set1(gain);
+    for (int s = 0; s < BRICK_SIZE; s += SSE2_LANES)
+    {
+        sse2_store(&output[s], sse2_mul(sse2_load(&input[s]), g));
+    }
+}
+
+static void firSse2(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output)
+{
+    sse2_t acc[SSE2_VECS];
+
+    for (int v = 0; v < SSE2_VECS; v++)
+    {
+        acc[v] = sse2_zero();
+    }
+
+    for (int i = 0; i < ntaps; i++)
+    {
+        sse2_t c = sse2_set1(coeffs[i]);
+        for (int v = 0; v < SSE2_VECS; v++)
+        {
+            acc[v] = sse2_add(acc[v], sse2_mul(c, sse2_load(&x[v * SSE2_LANES - i])));
+        }
+    }
+
+    for (int v = 0; v < SSE2_VECS; v++)
+    {
+        sse2_store(&output[v * SSE2_LANES], acc[v]);
+    }
+}
+
+static void firSymmetricSse2(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output)
+{
+    sse2_t acc[SSE2_VECS];
+
+    for (int v = 0; v < SSE2_VECS; v++)
+    {
+        acc[v] = sse2_zero();
+    }
+
+    for (int i = 0; i < ntaps / 2; i++)
+    {
+        sse2_t c = sse2_set1(coeffs[i]);
+        for (int v = 0; v < SSE2_VECS; v++)
+        {
+            sse2_t folded = sse2_add(sse2_load(&x[v * SSE2_LANES - i]),
+                                     sse2_load(&x[v * SSE2_LANES - (ntaps - 1 - i)]));
+            acc[v] = sse2_add(acc[v], sse2_mul(c, folded));
+        }
+    }
+
+    if (ntaps & 1)
+    {
+        sse2_t c = sse2_set1(coeffs[ntaps / 2]);
+        for (int v = 0; v < SSE2_VECS; v++)
+        {
+            acc[v] = sse2_add(acc[v], sse2_mul(c, sse2_load(&x[v * SSE2_LANES - ntaps / 2])));
+        }
+    }
+
+    for (int v = 0; v < SSE2_VECS; v++)
+    {
+        sse2_store(&output[v * SSE2_LANES], acc[v]);
+    }
+}
+
+static void mixLimitSse2(const FX_Sample_t* ch1, FX_Sample_t gain1, const FX_Sample_t* ch0, HAOS_PcmSample_t* output)
+{
+    sse2_t g = sse2_set1(gain1);
+    sse2_t one = sse2_set1(1);
+    sse2_t top = sse2_set1(LIMIT_TOP);
+    sse2_t bottom = sse2_set1(LIMIT_BOTTOM);
+
+    for (int s = 0; s < BRICK_SIZE; s += SSE2_LANES)
+    {
+        sse2_t ret = sse2_add(sse2_mul(sse2_load(&ch1[s]), g), sse2_load(&ch0[s]));
+
+        // No blend in SSE2, select with and/andnot/or
+        sse2_t mask = sse2_cmpge(ret, one);
+        ret = sse2_or(sse2_and(mask, top), sse2_andnot(mask, ret));
+        mask = sse2_cmplt(ret, bottom);
+        ret = sse2_or(sse2_and(mask, bottom), sse2_andnot(mask, ret));
+
+        sse2_store(&output[s], ret);
+    }
+}
+
+static const FX_Kernels sse2Kernels =
+{
+    "SSE2",
+    scaleSse2,
+    firSse2,
+    firSymmetricSse2,
+    mixLimitSse2
+};
+
+//==============================================================================
+// AVX2 kernels
+//
+// FMA is deliberately not used: fusing the 31 multiply-adds changes the rounding
+// of every step and the result would no longer match the scalar reference.
+//==============================================================================
+
+#if defined(__GNUC__)
+#define FX_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FX_TARGET_AVX2
+#endif
+
+#define AVX2_VECS (BRICK_SIZE / AVX2_LANES)
+
+FX_TARGET_AVX2 static void scaleAvx2(const FX_Sample_t* input, FX_Sample_t gain, FX_Sample_t* output)
+{
+    avx2_t g = avx2_set1(gain);
+    for (int s = 0; s < BRICK_SIZE; s += AVX2_LANES)
+    {
+        avx2_store(&output[s], avx2_mul(avx2_load(&input[s]), g));
+    }
+}
+
+FX_TARGET_AVX2 static void firAvx2(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output)
+{
+    avx2_t acc[AVX2_VECS];
+
+    for (int v = 0; v < AVX2_VECS; v++)
+    {
+        acc[v] = avx2_zero();
+    }
+
+    for (int i = 0; i < ntaps; i++)
+    {
+        avx2_t c = avx2_broadcast(&coeffs[i]);
+        for (int v = 0; v < AVX2_VECS; v++)
+        {
+            acc[v] = avx2_add(acc[v], avx2_mul(c, avx2_load(&x[v * AVX2_LANES - i])));
+        }
+    }
+
+    for (int v = 0; v < AVX2_VECS; v++)
+    {
+        avx2_store(&output[v * AVX2_LANES], acc[v]);
+    }
+}
+
+FX_TARGET_AVX2 static void firSymmetricAvx2(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output)
+{
+    avx2_t acc[AVX2_VECS];
+
+    for (int v = 0; v < AVX2_VECS; v++)
+    {
+        acc[v] = avx2_zero();
+    }
+
+    for (int i = 0; i < ntaps / 2; i++)
+    {
+        avx2_t c = avx2_broadcast(&coeffs[i]);
+        for (int v = 0; v < AVX2_VECS; v++)
+        {
+            avx2_t folded = avx2_add(avx2_load(&x[v * AVX2_LANES - i]),
+                                     avx2_load(&x[v * AVX2_LANES - (ntaps - 1 - i)]));
+            acc[v] = avx2_add(acc[v], avx2_mul(c, folded));
+        }
+    }
+
+    if (ntaps & 1)
+    {
+        avx2_t c = avx2_broadcast(&coeffs[ntaps / 2]);
+        for (int v = 0; v < AVX2_VECS; v++)
+        {
+            acc[v] = avx2_add(acc[v], avx2_mul(c, avx2_load(&x[v * AVX2_LANES - ntaps / 2])));
+        }
+    }
+
+    for (int v = 0; v < AVX2_VECS; v++)
+    {
+        avx2_store(&output[v * AVX2_LANES], acc[v]);
+    }
+}
+
+FX_TARGET_AVX2 static void mixLimitAvx2(const FX_Sample_t* ch1, FX_Sample_t gain1, const FX_Sample_t* ch0, HAOS_PcmSample_t* output)
+{
+    avx2_t g = avx2_set1(gain1);
+    avx2_t one = avx2_set1(1);
+    avx2_t top = avx2_set1(LIMIT_TOP);
+    avx2_t bottom = avx2_set1(LIMIT_BOTTOM);
+
+    for (int s = 0; s < BRICK_SIZE; s += AVX2_LANES)
+    {
+        avx2_t ret = avx2_add(avx2_mul(avx2_load(&ch1[s]), g), avx2_load(&ch0[s]));
+
+        ret = avx2_blendv(ret, top, avx2_cmp(ret, one, _CMP_GE_OQ));
+        ret = avx2_blendv(ret, bottom, avx2_cmp(ret, bottom, _CMP_LT_OQ));
+
+        avx2_store(&output[s], ret);
+    }
+}
+
+static const FX_Kernels avx2Kernels =
+{
+    "AVX2",
+    scaleAvx2,
+    firAvx2,
+    firSymmetricAvx2,
+    mixLimitAvx2
+};
+
+// Checks CPUID (and that the OS saves the YMM registers) for AVX2 support
+static bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    /* OSXSAVE and AVX */
+    __cpuid(info, 1);
+    if ((info[2] & (3 << 27)) != (3 << 27))
+    {
+        return false;
+    }
+
+    /* XMM and YMM state enabled by the OS */
+    if ((_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // FX_SIMD_X86
+
+//==============================================================================
+
+const FX_Kernels* FX_getScalarKernels()
+{
+    return &scalarKernels;
+}
+
+const FX_Kernels* FX_getKernels()
+{
+#if FX_SIMD_X86
+    if (cpuHasAvx2())
+    {
+        return &avx2Kernels;
+    }
+    return &sse2Kernels;
+#else
+    return &scalarKernels;
+#endif
+}
+
+const FX_Kernels* const* FX_getKernelSets()
+{
+#if FX_SIMD_X86
+    static const FX_Kernels* sets[] = { &scalarKernels, &sse2Kernels, cpuHasAvx2() ? &avx2Kernels : nullptr, nullptr };
+#else
+    static const FX_Kernels* sets[] = { &scalarKernels, nullptr };
+#endif
+
+    return sets;
+}
+
+#endif // !FX_Q31
@@ -0,0 +1,71 @@
+#ifndef FX_SIMD_H
+#define FX_SIMD_H
+
+#include <stdint.h>
+#include "haos_api.h"
+
+// SIMD kernels for the FX brick chain. Set FX_SIMD to 0 to always use the
+// scalar reference kernels.
+#ifndef FX_SIMD
+#define FX_SIMD 1
+#endif
+
+// Set FX_Q31 to 1 to run FX in 1.31 fixed point like the target DSP cores
+// (Q31 samples and coeffs, 64-bit accumulators, saturating adds). SIMD is not used then.
+#ifndef FX_Q31
+#define FX_Q31 0
+#endif
+
+#if FX_Q31
+// FX processes Q31 samples; bricks are converted from/to the IO buffer at the FX boundary
+typedef int32_t FX_Sample_t;
+
+// Converts to Q31 with rounding, saturated to [-1.0, 1.0)
+static inline FX_Sample_t FX_toSample(double x)
+{
+    double q = x * 2147483648.0;
+    if (q >= 2147483647.0) return INT32_MAX;
+    if (q <= -2147483648.0) return INT32_MIN;
+    return (FX_Sample_t)(q < 0 ? q - 0.5 : q + 0.5);
+}
+#else
+// FX processes samples in the haOS sample type (double, or float with HAOS_PCM_FLOAT32)
+typedef HAOS_PcmSample_t FX_Sample_t;
+
+static inline FX_Sample_t FX_toSample(double x)
+{
+    return (FX_Sample_t)x;
+}
+#endif
+
+// Kernel table, one entry per instruction set. All kernels process one whole brick
+// (BRICK_SIZE samples) and give bit-identical results: the SIMD versions vectorize
+// across samples and keep the scalar order of multiplies and adds (no FMA contraction).
+typedef struct
+{
+    const char* name;
+
+    // output[s] = input[s] * gain
+    void (*scale)(const FX_Sample_t* input, FX_Sample_t gain, FX_Sample_t* output);
+
+    // output[s] = sum(coeffs[i] * x[s - i]), i = 0 .. ntaps - 1
+    void (*fir)(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output);
+
+    // Same as fir, for symmetric coeffs: the delay line is folded around the centre tap
+    void (*firSymmetric)(const FX_Sample_t* x, const FX_Sample_t* coeffs, int ntaps, FX_Sample_t* output);
+
+    // output[s] = limit(ch1[s] * gain1 + ch0[s]), limited to [-1.0, 1.0) and written to the IO buffer
+    void (*mixLimit)(const FX_Sample_t* ch1, FX_Sample_t gain1, const FX_Sample_t* ch0, HAOS_PcmSample_t* output);
+} FX_Kernels;
+
+// Returns the scalar reference kernels (Q31 kernels with FX_Q31)
+const FX_Kernels* FX_getScalarKernels();
+
+// Returns the best kernels supported by the host CPU (CPUID check)
+const FX_Kernels* FX_getKernels();
+
+// Returns all kernel tables the host CPU supports, scalar first, terminated by a null pointer
+// (for tests/fx_simd_test.cpp)
+const FX_Kernels* const* FX_getKernelSets();
+
+#endif
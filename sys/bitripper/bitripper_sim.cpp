@@ -253,12 +253,6 @@ void advanceWritePtr(uint32_t wordsWritten)
     /* Get pointer to current state structure */
     pBitRipper_t pBitripper = &bitRipperInstance->currState;
 
-    /* If in auxiliary state, use main state backup for comparison */
-    if (bitRipperInstance->ctrlFlags & BITRIPPER_IN_AUX_STATE_FLAG)
-    {
-        pBitripper = &bitRipperInstance->mainStateBackup;
-    }
-
     /* Wrap around the FIFO if the pointer exceeds the end address */
     if (bitRipperInstance->writePtr >= pBitripper->endAddrPlus1)
     {
@@ -273,6 +267,17 @@ void advanceWritePtr(uint32_t wordsWritten)
     {
         bitRipperInstance->ctrlFlags |= BITRIPPER_FIFO_FULL_FLAG;
     }
+
+    /* In auxiliary state, the saved main state has its own full flag */
+    if (bitRipperInstance->ctrlFlags & BITRIPPER_IN_AUX_STATE_FLAG)
+    {
+        bitRipperInstance->ctrlFlags &= BITRIPPER_MAIN_FIFO_FULL_CLR;
+
+        if (bitRipperInstance->writePtr == bitRipperInstance->mainStateBackup.readPtr)
+        {
+            bitRipperInstance->ctrlFlags |= BITRIPPER_MAIN_FIFO_FULL_FLAG;
+        }
+    }
 }
 
 
@@ -293,57 +298,8 @@ void advanceWritePtr(uint32_t wordsWritten)
  */
 int32_t extractBits(uint32_t bitsNeeded)
 {
-    /* bitsNeeded must be in the range [1, MAX_BITS] */
-    assert((bitsNeeded >= 1) && (bitsNeeded <= MAX_BITS) && "Invalid extract bits argument!");
-
-    /* Get BitRipper core and current state for the active HaOS core */
-    pBitRipperState_t pBitRipperState = (pBitRipperState_t)HAOS::getActiveCoreBitRipper();
-    pBitRipper_t pCurrState = &pBitRipperState->currState;
-
-    /* Extract the first part from the current word */
-    uint32_t result = pCurrState->currentWord >> (MAX_BITS - bitsNeeded);
-    int32_t extractRemainingBits = bitsNeeded - pCurrState->bitsRemaining;
-
-    /* If the current word doesn't have enough bits, read the next one */
-    if (extractRemainingBits > 0)
-    {
-        /* Wait until the next word is available (FIFO not empty) */
-        while ((pCurrState->readPtr == *pCurrState->pWritePtr) &&
-               (!(pBitRipperState->ctrlFlags & BITRIPPER_FIFO_FULL_FLAG)))
-        {
-			/* Refill FIFO if needed */
-            HAOS::fillInputFIFO();
-        }
-
-        /* Load the next word into currentWord */
-        pCurrState->currentWord = *pCurrState->readPtr++;
-        pBitRipperState->ctrlFlags &= BITRIPPER_FIFO_FULL_CLR;
-
-        /* Wrap read pointer if end of FIFO is reached */
-        if (pCurrState->readPtr == pCurrState->endAddrPlus1)
-        {
-            pCurrState->readPtr = pCurrState->baseAddr;
-        }
-
-        /* Extract the remaining bits from the newly loaded word */
-        bitsNeeded = extractRemainingBits;
-        result |= pCurrState->currentWord >> (MAX_BITS - bitsNeeded);
-
-        /* Reset bitsRemaining after loading new word */
-        pCurrState->bitsRemaining = MAX_BITS;
-    }
-
-    /* Shift currentWord to discard the extracted bits */
-    pCurrState->currentWord <<= bitsNeeded;
-
-    /* Decrease bitsRemaining accordingly */
-    pCurrState->bitsRemaining -= bitsNeeded;
-
-    /* If no bits are left, clear the word */
-    if (pCurrState->bitsRemaining == 0)
-        pCurrState->currentWord = 0;
-
-    return result;
+    /* Get BitRipper core for the active HaOS core and extract from it */
+    return extractBits(getActiveState(), bitsNeeded);
 }
 
 
@@ -362,40 +318,94 @@ int32_t extractBits(uint32_t bitsNeeded)
  */
 uint32_t peek(uint32_t bitsNeeded)
 {
-    /* bitsNeeded must be in the range [1, MAX_BITS] */
-    assert((bitsNeeded >= 1) && (bitsNeeded <= MAX_BITS) && "Invalid peek bits argument!");
+    /* Get BitRipper core for the active HaOS core and peek into it */
+    return peek(getActiveState(), bitsNeeded);
+}
 
-    /* Get BitRipper core and current state for the active HaOS core */
-    pBitRipperState_t pBitRipperState = (pBitRipperState_t)HAOS::getActiveCoreBitRipper();
-    pBitRipper_t pCurrState = &pBitRipperState->currState;
 
-    /* Extract the first part from the current word */
-    uint32_t result = pCurrState->currentWord >> (MAX_BITS - bitsNeeded);
-    int32_t peekRemainingBits = bitsNeeded - pCurrState->bitsRemaining;
+/*
+ * Waits until the input FIFO holds the word after the read pointer of a BitRipper state.
+ *
+ * This is the slow path of the inline extract and peek variants: while the read pointer has
+ * reached the write pointer and the FIFO is not full, the FIFO is refilled.
+ *
+ * @param pState BitRipper state of the active core.
+ */
+void waitForWord(pBitRipperState_t pState)
+{
+    pBitRipper_t pCurrState = &pState->currState;
 
-    /* If more bits are needed beyond current word */
-    if (peekRemainingBits > 0)
+    while ((pCurrState->readPtr == *pCurrState->pWritePtr) &&
+           (!(pState->ctrlFlags & BITRIPPER_FIFO_FULL_FLAG)))
     {
-        /* Wait until FIFO has data */
-        while ((pCurrState->readPtr == *pCurrState->pWritePtr) &&
-               (!(pBitRipperState->ctrlFlags & BITRIPPER_FIFO_FULL_FLAG)))
+        /* Refill FIFO if needed */
+        HAOS::fillInputFIFO();
+    }
+}
+
+
+/*
+ * Extracts a number of 32-bit words from the BitRipper input stream.
+ *
+ * On a word boundary, the words are copied out of the FIFO one contiguous span at a time. A span
+ * ends at the write pointer, or at the end of the FIFO if the data wraps around (or the FIFO is
+ * full). The current word stays empty, as it would after `extractBits(32)`. Off a word boundary,
+ * every word is put together from two FIFO words.
+ *
+ * @param pState  BitRipper state of the active core.
+ * @param dst     Destination of the words.
+ * @param wordCnt Number of words to extract.
+ */
+void extractWords(pBitRipperState_t pState, uint32_t* dst, uint32_t wordCnt)
+{
+    pBitRipper_t pCurrState = &pState->currState;
+
+    if (pCurrState->bitsRemaining)
+    {
+        /* Not word aligned, every word spans two FIFO words */
+        for (uint32_t word = 0; word < wordCnt; word++)
         {
-            /* Refill FIFO if needed */
-            HAOS::fillInputFIFO();
+            dst[word] = extractBits(pState, MAX_BITS);
         }
+        return;
+    }
+
+    while (wordCnt > 0)
+    {
+        /* Wait until the next word is available (FIFO not empty) */
+        waitForWord(pState);
 
-        /* Load the next word for temporary inspection */
-        uint32_t currentWord = *pCurrState->readPtr;
+        /* Words up to the write pointer, or up to the end of the FIFO if they wrap */
+        uint32_t* writePtr = *pCurrState->pWritePtr;
+        uint32_t* spanEnd = (writePtr > pCurrState->readPtr) ? writePtr : pCurrState->endAddrPlus1;
+        uint32_t spanCnt = (uint32_t)(spanEnd - pCurrState->readPtr);
 
-        /* Extract the remaining bits from the next word */
-        bitsNeeded = peekRemainingBits;
-        result |= currentWord >> (MAX_BITS - bitsNeeded);
-    }
+        if (spanCnt > wordCnt)
+        {
+            spanCnt = wordCnt;
+        }
+
+        memcpy(dst, pCurrState->readPtr, spanCnt * sizeof(uint32_t));
+        dst += spanCnt;
+        wordCnt -= spanCnt;
 
-    return result;
+        pCurrState->readPtr += spanCnt;
+        pState->ctrlFlags &= BITRIPPER_FIFO_FULL_CLR;
+
+        /* Wrap read pointer if end of FIFO is reached */
+        if (pCurrState->readPtr == pCurrState->endAddrPlus1)
+        {
+            pCurrState->readPtr = pCurrState->baseAddr;
+        }
+    }
 }
 
 
+void extractWords(uint32_t* dst, uint32_t wordCnt)
+{
+    extractWords(getActiveState(), dst, wordCnt);
+}
+
 
 /*
  * Skips a specified number of bits in the BitRipper input stream.
@@ -466,6 +476,12 @@ void skipBits(int32_t skipBits)
 		{
 			newReadPtr -= pCurrState->size;
 		}
+
+		/* Words were consumed, the FIFO is no longer full */
+		if (newReadPtr != pCurrState->readPtr)
+		{
+			pBitRipperState->ctrlFlags &= BITRIPPER_FIFO_FULL_CLR;
+		}
 	}
 	else
 	{
@@ -548,17 +564,21 @@ uint32_t readDipstick()
 	/* Get a pointer to the current state of the active BitRipper */
 	pBitRipper_t pCurrState = &pBitRipperState->currState;
 
+	/* Full flag of the state the dipstick is read for */
+	HAOS_CtrlFlags_t fullFlag = BITRIPPER_FIFO_FULL_FLAG;
+
 	if (pBitRipperState->ctrlFlags & BITRIPPER_IN_AUX_STATE_FLAG)
 	{
 		/* Use main backup state if in AUX state */
 		pCurrState = &pBitRipperState->mainStateBackup;
+		fullFlag = BITRIPPER_MAIN_FIFO_FULL_FLAG;
 	}
 
 	/* Compute number of full words between write and read pointers */
 	bitsInFIFO = *pCurrState->pWritePtr - pCurrState->readPtr;
 
 	if ((bitsInFIFO < 0) ||
-		((!bitsInFIFO) && (pBitRipperState->ctrlFlags & BITRIPPER_FIFO_FULL_FLAG)))
+		((!bitsInFIFO) && (pBitRipperState->ctrlFlags & fullFlag)))
 	{
 		/* Handle wrap-around of circular buffer */
 		bitsInFIFO += pCurrState->size;
@@ -640,6 +660,13 @@ void saveMainState()
     /* Save the current state into the backup location (excluding write pointers) */
     memcpy(pMainStateBckp, pCurrState, sizeof(BitRipper_t));
 
+    /* The reads in auxiliary mode clear the full flag, the main state keeps its own copy */
+    pBitRipperState->ctrlFlags &= BITRIPPER_MAIN_FIFO_FULL_CLR;
+    if (pBitRipperState->ctrlFlags & BITRIPPER_FIFO_FULL_FLAG)
+    {
+        pBitRipperState->ctrlFlags |= BITRIPPER_MAIN_FIFO_FULL_FLAG;
+    }
+
     /* Set control flag indicating the system is now operating in auxiliary mode */
     pBitRipperState->ctrlFlags |= BITRIPPER_IN_AUX_STATE_FLAG;
 }
@@ -672,8 +699,15 @@ void restoreMainState()
     /* Restore FIFO read pointer and other relevant state fields (excluding write pointers) */
     memcpy(pCurrState, pMainStateBckp, sizeof(BitRipper_t));
 
+    /* Restore the full flag of the main state */
+    pBitRipperState->ctrlFlags &= BITRIPPER_FIFO_FULL_CLR;
+    if (pBitRipperState->ctrlFlags & BITRIPPER_MAIN_FIFO_FULL_FLAG)
+    {
+        pBitRipperState->ctrlFlags |= BITRIPPER_FIFO_FULL_FLAG;
+    }
+
     /* Clear the AUX state flag to resume normal decoding */
-    pBitRipperState->ctrlFlags &= BITRIPPER_IN_AUX_STATE_CLR;
+    pBitRipperState->ctrlFlags &= BITRIPPER_IN_AUX_STATE_CLR & BITRIPPER_MAIN_FIFO_FULL_CLR;
 }
 
 
@@ -702,7 +736,7 @@ void loadMainState(pBitRipper_t pAuxState)
     memcpy(pCurrState, pAuxState, sizeof(BitRipper_t));
 
     /* Clear the AUX state flag to resume normal decoding */
-    pBitRipperState->ctrlFlags &= BITRIPPER_IN_AUX_STATE_CLR;
+    pBitRipperState->ctrlFlags &= BITRIPPER_IN_AUX_STATE_CLR & BITRIPPER_MAIN_FIFO_FULL_CLR;
 }
 
 
@@ -9,6 +9,7 @@
 #define __BITRIPPER_H__
 
 
+#include <assert.h>
 #include "haos_api.h"
 
 
@@ -19,6 +20,9 @@
 #define BITRIPPER_FIFO_FULL_FLAG             	BIT_01_SET 			// flag for full FIFO
 #define BITRIPPER_FIFO_FULL_CLR             	BIT_01_CLR
 
+#define BITRIPPER_MAIN_FIFO_FULL_FLAG          	BIT_02_SET 			// flag for full FIFO seen from the saved main state (aux state)
+#define BITRIPPER_MAIN_FIFO_FULL_CLR          	BIT_02_CLR
+
 #define MAX_BITS 	32
 
 namespace BitRipper
@@ -303,6 +307,116 @@ namespace BitRipper
     */
     void alignToDWord();
 
+    /*
+    * Waits until the input FIFO holds the word after the read pointer of a BitRipper state.
+    *
+    * This is the slow path of the inline extract and peek variants below. It refills the FIFO
+    * via `HAOS::fillInputFIFO()` in the same way `extractBits()` does.
+    *
+    * @param pState BitRipper state of the active core.
+    */
+    void waitForWord(pBitRipperState_t pState);
+
+    /*
+    * Extracts a number of 32-bit words from the BitRipper input stream.
+    *
+    * The result is the same as `wordCnt` calls of `extractBits(32)`. When the read position is on a word
+    * boundary, the words are copied out of the FIFO with memcpy, one contiguous span (up to the write
+    * pointer or the end of the FIFO) at a time, and the FIFO is refilled between the spans. Otherwise
+    * every word is assembled from two FIFO words by the inline `extractBits()`.
+    *
+    * @param pState  BitRipper state of the active core, see `getActiveState()`.
+    * @param dst     Destination of the words.
+    * @param wordCnt Number of words to extract.
+    */
+    void extractWords(pBitRipperState_t pState, uint32_t* dst, uint32_t wordCnt);
+
+    /*
+    * Same as `extractWords(pState, dst, wordCnt)` for the BitRipper of the active core.
+    */
+    void extractWords(uint32_t* dst, uint32_t wordCnt);
+
+    /*
+    * Returns the BitRipper state of the active HaOS core.
+    *
+    * The inline variants below take the state explicitly, so a decoder looks it up once
+    * per entry point call instead of once per extracted field.
+    */
+    static inline pBitRipperState_t getActiveState()
+    {
+        return (pBitRipperState_t)HAOS::getActiveCoreBitRipper();
+    }
+
+    /*
+    * Inline variant of `extractBits()` for the given BitRipper state.
+    *
+    * Bits within the current word are taken with one shift. When the request crosses into the next
+    * FIFO word, the rest of the current word and the next word are combined into a 64-bit window
+    * and the bits are taken from it, so no shift by 32 is needed for 32-bit extracts.
+    */
+    static inline int32_t extractBits(pBitRipperState_t pState, uint32_t bitsNeeded)
+    {
+        assert((bitsNeeded >= 1) && (bitsNeeded <= MAX_BITS) && "Invalid extract bits argument!");
+
+        pBitRipper_t pCurrState = &pState->currState;
+
+        if (bitsNeeded <= pCurrState->bitsRemaining)
+        {
+            uint32_t result = pCurrState->currentWord >> (MAX_BITS - bitsNeeded);
+
+            /* the consumed bits are shifted out, an empty word is 0 */
+            pCurrState->currentWord = (uint32_t)((uint64_t)pCurrState->currentWord << bitsNeeded);
+            pCurrState->bitsRemaining -= bitsNeeded;
+
+            return result;
+        }
+
+        if ((pCurrState->readPtr == *pCurrState->pWritePtr) && (!(pState->ctrlFlags & BITRIPPER_FIFO_FULL_FLAG)))
+        {
+            waitForWord(pState);
+        }
+
+        /* remaining bits of the current word followed by the next word, MSB aligned */
+        uint64_t window = ((uint64_t)pCurrState->currentWord << MAX_BITS) |
+                          ((uint64_t)*pCurrState->readPtr++ << (MAX_BITS - pCurrState->bitsRemaining));
+        pState->ctrlFlags &= BITRIPPER_FIFO_FULL_CLR;
+
+        if (pCurrState->readPtr == pCurrState->endAddrPlus1)
+        {
+            pCurrState->readPtr = pCurrState->baseAddr;
+        }
+
+        pCurrState->currentWord = (uint32_t)((window << bitsNeeded) >> MAX_BITS);
+        pCurrState->bitsRemaining += MAX_BITS - bitsNeeded;
+
+        return (uint32_t)(window >> (2 * MAX_BITS - bitsNeeded));
+    }
+
+    /*
+    * Inline variant of `peek()` for the given BitRipper state.
+    */
+    static inline uint32_t peek(pBitRipperState_t pState, uint32_t bitsNeeded)
+    {
+        assert((bitsNeeded >= 1) && (bitsNeeded <= MAX_BITS) && "Invalid peek bits argument!");
+
+        pBitRipper_t pCurrState = &pState->currState;
+
+        if (bitsNeeded <= pCurrState->bitsRemaining)
+        {
+            return pCurrState->currentWord >> (MAX_BITS - bitsNeeded);
+        }
+
+        if ((pCurrState->readPtr == *pCurrState->pWritePtr) && (!(pState->ctrlFlags & BITRIPPER_FIFO_FULL_FLAG)))
+        {
+            waitForWord(pState);
+        }
+
+        uint64_t window = ((uint64_t)pCurrState->currentWord << MAX_BITS) |
+                          ((uint64_t)*pCurrState->readPtr << (MAX_BITS - pCurrState->bitsRemaining));
+
+        return (uint32_t)(window >> (2 * MAX_BITS - bitsNeeded));
+    }
+
 }
 
 namespace bitripper_internal
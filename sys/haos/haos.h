@@ -14,6 +14,7 @@
 #include "wavefile.h"
 #include "haos_api.h"
 #include "haos_config.h"
+#include "haos_brickqueue.h"
 
  /* Number of bits per sample */
 #define OUTPUT_HANDLER_BITS_PER_SAMPLE_DFLT     16
@@ -21,6 +22,13 @@
 /* Number of dummy frames to process after EOF is detected in the input stream */
 #define HAOS_FLUSH_FRAMES_CNT_DFLT     10
 
+/* Frame sizes in samples, the default fg2bg ratio is the number of bricks per frame */
+#define HAOS_PCM_FRAME_SIZE     256
+#define HAOS_MP3_FRAME_SIZE     1152
+
+/* Wall-clock interval (ms) between output file header updates during the run */
+#define HAOS_OUTPUT_UPDATE_INTERVAL_DFLT     1000
+
 
 // Bitmask definitions for control flags used in the system.
 #define HAOS_STREAM_FIRST_OPEN_FLAG			BIT_00_SET			// Indicates whether the input file is being opened for the first time
@@ -53,14 +61,16 @@ enum HAOS_ROUTINE
 	AFAP,
 	BACKGROUND,
 	POSTMALLOC,
-	PREMALLOC
+	PREMALLOC,
+	MCV_CHANGED,
+	HAOS_ROUTINES_CNT	// number of MCT entry points
 };
 
 // Represents a single entry in the Overlay Definition Table (ODT).
 //
 // Each ODT entry describes one audio processing module assigned to a core.
 // It includes a pointer to the module's Module Interface Structure (MIF),
-// and the module's unique identifier.
+// the module's unique identifier and an optional name used in reports (e.g. the profiler).
 //
 // These entries are used during system initialization to build the per-core
 // module execution lists (pipelines).
@@ -68,6 +78,7 @@ typedef struct
 {
 	HAOS_Mif_t* MIF;
 	uint32_t 	moduleID;
+	const char*	name;
 } HAOS_OdtEntry_t, * pHAOS_OdtEntry_t;
 
 
@@ -84,6 +95,33 @@ typedef HAOS_OdtEntry_t HAOS_Odt_t[];
 // type used to represent a sequence of incoming host comm messages
 typedef HAOS_OdtEntry_t HAOS_ModuleTable_t[MAX_MODULES_COUNT];
 
+// How the values of an MCV write range are applied to the words (the host comm opcode)
+typedef enum
+{
+	HAOS_MCV_WRITE = 0,
+	HAOS_MCV_OR = 1,
+	HAOS_MCV_AND = 2,
+	HAOS_MCV_APPLIED = 3	// the words are already in the MCV, only the module is notified
+} HAOS_McvOp_t;
+
+// Range of MCV words written by the host. The values are written to the MCV by the core of the
+// module, right before the module is notified, so no other thread touches the module's MCV.
+typedef struct
+{
+	uint32_t offset;	// first word
+	uint32_t wordCnt;	// number of words
+	uint64_t brick;		// index of the first brick that sees the write (see HAOS_Core_t::brickIdx)
+	HAOS_McvOp_t op;	// how the values are applied
+	uint32_t values[MAX_MCV_RANGE_WORDS];	// payload of the write, one value per word
+} HAOS_McvRange_t;
+
+// MCV words of one module written by the host since the module was last notified
+typedef struct
+{
+	uint32_t rangesCnt;
+	HAOS_McvRange_t ranges[MAX_MCV_CHANGED_RANGES];
+} HAOS_McvChanges_t;
+
 
 /**
  * @brief Structure representing a single processing core in the HAOS system.
@@ -102,25 +140,44 @@ typedef struct
 	/* Number of registered modules in the core ODT table s*/
 	uint32_t modulesCnt;
 
+	// MCV words written by the host, per module of the ODT, not notified yet.
+	// mcvChanged is set when any module has changes, it's checked before each entry point.
+	HAOS_McvChanges_t mcvChanges[MAX_MODULES_COUNT];
+	std::atomic<bool> mcvChanged;
+
+	// Index of the brick the core is processing, counted from the start of the stream.
+	// A core running on its own thread is behind core 0, the host's MCV writes are
+	// notified when the core reaches the brick they were made for.
+	uint64_t brickIdx;
+
 	// Bitmask of valid I/O channels for post-processing (PPM).
 	// Each bit represents one audio channel (bit 0 = ch0, ..., bit 31 = ch31).
 	// A bit value of 1 means the channel is enabled and should be processed.
 	// Used by modules to skip inactive channels and improve performance.
+	// A channel with a 0 bit is silent: the system doesn't clear or copy its I/O bricks,
+	// their content is undefined and the output writer writes zeros for it.
 	HAOS_ChannelMask_t HAOS_PPM_VALID_CHANNELS;
 
 	// Global I/O buffer used by all modules in this core.
-	// Each channel has a circular array of buffers used for block-based audio processing.
-	//HAOS_BrickBuffer_t IOBUFFER[NUMBER_OF_IO_CHANNELS][IO_BUFFER_PER_CHAN_MODULO];
-	HAOS_BrickBuffer_t(*IOBUFFER)[IO_BUFFER_PER_CHAN_MODULO];
+	// Each channel has a circular array of buffers used for block-based audio processing,
+	// only the first IOring.mask + 1 are used.
+	//HAOS_BrickBuffer_t IOBUFFER[NUMBER_OF_IO_CHANNELS][IO_BUFFER_BRICKS_MAX];
+	HAOS_BrickBuffer_t(*IOBUFFER)[IO_BUFFER_BRICKS_MAX];
+
+	// Pointers to the bricks of all I/O channels, one row per brick of the ring
+	HAOS_PcmSamplePtr_t IOBUFFER_BRICK_PTRS[IO_BUFFER_BRICKS_MAX][NUMBER_OF_IO_CHANNELS];
 
 	// Internal input pointers for each I/O channel, used for accessing the active input buffer
-	HAOS_PcmSamplePtr_t HAOS_IOBUFFER_INP_PTRS[NUMBER_OF_IO_CHANNELS];
+	// (row of IOBUFFER_BRICK_PTRS)
+	HAOS_PcmSamplePtr_t* HAOS_IOBUFFER_INP_PTRS;
 
 	// Internal output pointers for each I/O channel, used for accessing the active output buffer
-	HAOS_PcmSamplePtr_t HAOS_IOBUFFER_PTRS[NUMBER_OF_IO_CHANNELS];
+	// (row of IOBUFFER_BRICK_PTRS)
+	HAOS_PcmSamplePtr_t* HAOS_IOBUFFER_PTRS;
 
-	// Amount of free space in the I/O buffer for a single channel, expressed in PCM samples.
-	int32_t IOfree;
+	// Ring of the I/O buffer bricks. The decoder writes at the head (HAOS_IOBUFFER_INP_PTRS),
+	// the modules and the output writer read at the tail (HAOS_IOBUFFER_PTRS).
+	HAOS_BrickRing_t IOring;
 
 
 	// BitRipper state and FIFO buffer specific to the core
@@ -190,20 +247,14 @@ typedef struct
 	// Table containing the list of all core instances in the system
 	HAOS_CoreTable_t coreTable;
 
-	// Pointer to the currently active DSP core
-	pHAOS_Core_t pActiveCore;
-
 	// Pointer to statically allocated system I/O buffers
-	int32_t* systemIObuffers;
+	HAOS_PcmSample_t* systemIObuffers;
 
 	// Pointer to statically allocated system FIFO buffers (used by decoders/BitRipper)
 	uint32_t* systemFIFObuffers;
 
-	// Input read brick index (used to wrap the read position in the circular I/O buffer)
-	int32_t readBrickCnt;
-
-	// Output write brick index (used to wrap the write position in the circular I/O buffer)
-	int32_t writeBrickCnt;
+	// Number of brick slots per channel in the I/O buffer rings (power of 2, --iobricks)
+	uint32_t ioBricks;
 
 	// Flag used to mark the start of a new frame (e.g., for synchronization or logging)
 	// bool frameTriggered;
@@ -226,6 +277,15 @@ typedef struct
 	// Path to the configuration file used during the prekick stage (e.g., gain.cfg)
 	std::string cfgPath;
 
+	// Path of a file the host appends commands to during the run (--hostcomm), empty = none
+	std::string hostCommPath;
+
+	// Path to a reference WAV file the output is compared against after the run (--ref)
+	std::string refPath;
+
+	// Path of the JSON file the profiler results are written to (--profile), empty = no profiling
+	std::string profilePath;
+
 	const char* tomlPath;
 
 	// Foreground-to-background processing ratio (e.g., 16 for PCM, 72 for MP3)
@@ -238,6 +298,21 @@ typedef struct
 	/* Flush counter, decremented after each processed frame once EOF is detected */
 	uint32_t flushDataCnt;
 
+	/* Set while a decoder reading ahead on its own thread holds the end of the input stream,
+	   the input EOF flag is written by that thread and is not looked at until it's released */
+	std::atomic<bool> inputEndHeld;
+
+	/* Wall-clock interval (ms) between output file header updates (--oupdate), 0 = every frame */
+	int32_t outUpdateInterval;
+
+	/* Batch rendering (--offline): no header updates during the run, no debug logs,
+	   large output buffer, throughput report at the end */
+	bool offline;
+
+	/* Run all cores on the main thread, one after the other (--sequential). By default
+	   each core runs on its own thread and the bricks are pipelined from core to core */
+	bool sequential;
+
 } HAOS_System_t, * pHAOS_System_t;
 
 extern bool useMp3;
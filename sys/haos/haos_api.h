@@ -52,7 +52,19 @@
 ///
 /// Defines the number of audio samples processed per channel in one pass.
 /// Used to manage circular buffers and frame-based signal flow across modules.
-#define BRICK_SIZE                  16
+///
+/// Build with HAOS_BRICK_SIZE=32, 64, 128 or 256 to cut the per-brick overhead
+/// (e.g. for offline renders); 16 keeps the latency of the target. All brick loops
+/// are sized by this constant, so each build is specialized for its brick size.
+#ifndef HAOS_BRICK_SIZE
+#define HAOS_BRICK_SIZE             16
+#endif
+
+#define BRICK_SIZE                  HAOS_BRICK_SIZE
+
+#if (BRICK_SIZE != 16) && (BRICK_SIZE != 32) && (BRICK_SIZE != 64) && (BRICK_SIZE != 128) && (BRICK_SIZE != 256)
+#error "HAOS_BRICK_SIZE must be 16, 32, 64, 128 or 256"
+#endif
 
 
 // Special flag indicating a disconnected or unassigned I/O source.
@@ -98,10 +110,24 @@ typedef void __fg_call HAOS_PrekickCallback_t(void* mif);
  */
 typedef void __bg_call HAOS_BackgroundCallback_t();
 
+/**
+ *  @brief a function that is called when the host has written to the MCV
+ *
+ *  Called in the foreground, before the other entry points of the module's core, once for
+ *  each range of MCV words written by host comm messages since the previous call.
+ *  A range may extend past the end of the MCV, the module ignores those words.
+ *
+ *  @param offset First written word of the MCV (32-bit words)
+ *  @param wordCnt Number of written words
+ *
+ *  @ingroup module_api
+ */
+typedef void __fg_call HAOS_McvChangedCallback_t(uint32_t offset, uint32_t wordCnt);
+
 /**
  *  @brief The Module Call Table (MCT) is a table of framework entry points.
  *
- *  This table contains 8 optional entry points that may be called by
+ *  This table contains 10 optional entry points that may be called by
  *  the OS Framework.
  *
  *  @param framework_prekick_entry_point_t* <b>prekick_func_ptr</b>
@@ -175,6 +201,13 @@ typedef void __bg_call HAOS_BackgroundCallback_t();
  *   the entire set of requests, the systems halts.
  *   If the Malloc succeeds, the OS calls the Post Malloc functions.
  *
+ *  @param HAOS_McvChangedCallback_t* <b>McvChanged</b>
+ *   Called after the host has written to the MCV, with the range of written words.
+ *   The OS writes the words on the module's core, right before the call, at the brick
+ *   the host has sent them for.
+ *   The module applies only the fields in the range instead of polling the whole MCV.
+ *   Modules without it read the MCV themselves.
+ *
  *  @ingroup module_api
  */
 typedef struct {
@@ -187,6 +220,7 @@ typedef struct {
     HAOS_BackgroundCallback_t* Background;
     HAOS_ForegroundCallback_t* Postmalloc;
     HAOS_ForegroundCallback_t* Premalloc;
+    HAOS_McvChangedCallback_t* McvChanged;
 } HAOS_Mct_t, * pHAOS_Mct_t;
 
 
@@ -321,9 +355,19 @@ typedef struct
 } HAOS_Mif_t, * pHAOS_Mif_t;
 
 
+// Sample type selection. Build with HAOS_PCM_FLOAT32=1 to run the whole pipeline
+// (IO buffer, decoders and processing modules) in 32-bit float instead of double.
+#ifndef HAOS_PCM_FLOAT32
+#define HAOS_PCM_FLOAT32 0
+#endif
+
 // Represents a single PCM audio sample in the I/O buffer.
 // Typically 32-bit signed integer in fixed-point systems.
+#if HAOS_PCM_FLOAT32
+typedef float HAOS_PcmSample_t;
+#else
 typedef double HAOS_PcmSample_t;
+#endif
 
 // Pointer to a PCM audio sample in the I/O buffer.
 typedef HAOS_PcmSample_t* HAOS_PcmSamplePtr_t;
@@ -460,6 +504,24 @@ typedef struct
 #define BIT_30_CLR      (~BIT_30_SET)
 #define BIT_31_CLR      (~BIT_31_SET)
 
+// Returns the index of the lowest set bit of a channel mask, the mask must not be 0.
+// Iterates over the channels of a mask with one bit scan per channel:
+//     for (HAOS_ChannelMask_t m = mask; m != 0; m &= m - 1) { int32_t ch = HAOS_lowestChannel(m); ... }
+#if defined(_MSC_VER)
+#include <intrin.h>
+static inline int32_t HAOS_lowestChannel(HAOS_ChannelMask_t mask)
+{
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return (int32_t)idx;
+}
+#else
+static inline int32_t HAOS_lowestChannel(HAOS_ChannelMask_t mask)
+{
+    return __builtin_ctz(mask);
+}
+#endif
+
 typedef struct
 {
     uint32_t  	ID;
@@ -613,6 +675,15 @@ namespace HAOS
     bool getEndOfProcessing();
 
 
+    // @brief Returns whether the simulator runs in offline (batch) mode.
+    //
+    // In offline mode the simulator renders as fast as possible and the console
+    // output is kept to a minimum. Modules should skip their debug logging then.
+    //
+    // @return true if --offline was given on the command line, false otherwise.
+    bool getOfflineMode();
+
+
     // @brief Returns the sample rate (number of samples per second) of the input stream.
     //
     // This function provides the current input stream sampling frequency (FS),
@@ -648,10 +719,29 @@ namespace HAOS
     // It is typically called after each decoding step to prepare audio data for further
     // processing stages within the audio pipeline.
     //
+    // Only the channels of the input channel mask of the current frame are copied, the
+    // others are silent and are not cleared.
+    //
     // @param copyToIOPtrs Pointer to a structure containing source sample data and
     //                     target I/O buffer channel and offset information.
     void copyBrickToIO(pHAOS_CopyToIOPtrs_t copyToIOPtrs);
 
+    // @brief Returns the I/O buffer bricks the decoder writes next, one pointer per I/O channel.
+    //
+    // Lets a decoder decode or deinterleave straight into the I/O buffer instead of
+    // preparing the brick in its own buffer for copyBrickToIO(). Only the bricks of the
+    // channels of its input channel mask need to be written. Must be followed by
+    // commitInputBricks().
+    //
+    // @return Table of NUMBER_OF_IO_CHANNELS brick pointers.
+    HAOS_PcmSamplePtr_t* acquireInputBricks();
+
+    // @brief Hands the bricks returned by acquireInputBricks() to the processing modules.
+    //
+    // @param frameData Pointer to the current frame's metadata, nullptr if the brick
+    //                  doesn't start a frame (as in HAOS_CopyToIOPtrs_t).
+    void commitInputBricks(pHAOS_FrameData_t frameData);
+
     // @brief Refills the input bitstream FIFO buffer from the input file.
     //
     // This function is called when the input FIFOused by the decoder to read compressed audio data
@@ -674,6 +764,25 @@ namespace HAOS
     void* getActiveCoreBitRipper();
     void* getActiveCore();
 
+    // @brief Makes a core the active core of the calling thread.
+    //
+    // For a worker thread a module starts from one of its entry points: pCore is the value
+    // getActiveCore() returned there. The thread then uses the BitRipper and the input FIFO
+    // of that core, the module must not use them from its entry points in the meantime.
+    //
+    // @param pCore Core returned by getActiveCore().
+    void setActiveCore(void* pCore);
+
+    // @brief Holds the end of the input stream while a decoder reads ahead on its own thread.
+    //
+    // The input EOF is reached long before the last decoded brick is handed to the system
+    // by such a decoder. While the hold is set, the EOF doesn't start the flush frames at the
+    // end of the run. The decoder sets the hold before its thread starts and releases it
+    // once its last brick is committed and its thread is joined.
+    //
+    // @param hold true to hold the end of the stream, false to release it.
+    void holdInputStreamEnd(bool hold);
+
     // @brief Requests memory allocation from the system.
     //
     // This function sets the system memory allocation request flag and optionally
@@ -0,0 +1,165 @@
+/*
+ * haos_brickqueue.h
+ *
+ * Lock-free single-producer/single-consumer rings of bricks.
+ *
+ * HAOS_BrickRing_t only keeps the indices of a ring, the bricks are stored by its
+ * owner. Each core's IO buffer is one: the decoder writes bricks at the head, the
+ * post-processing and the output writer consume them at the tail. The producer and
+ * the consumer may run on different threads.
+ *
+ * HAOS_BrickQueue_t is a ring with its own slots. When the cores run on their own
+ * threads, core N hands every processed brick to core N + 1 through one.
+ */
+
+#ifndef HAOS_BRICKQUEUE_H__
+#define HAOS_BRICKQUEUE_H__
+
+#include <atomic>
+#include <thread>
+#include "haos_api.h"
+
+// Number of bricks in flight between two cores, must be a power of 2
+#define HAOS_BRICK_QUEUE_SIZE		8
+
+// Host cache line size; head, tail and the slots don't share lines
+#define HAOS_CACHE_LINE_SIZE		64
+
+// Flags of a queued brick
+#define HAOS_BRICK_FRAME_FLAG		BIT_00_SET	// A frame was triggered with this brick
+#define HAOS_BRICK_END_FLAG			BIT_01_SET	// No more bricks, the pipeline shuts down
+
+typedef struct
+{
+	// Number of bricks written, only stored by the producer
+	alignas(HAOS_CACHE_LINE_SIZE) std::atomic<uint32_t> head;
+
+	// Number of bricks read, only stored by the consumer
+	alignas(HAOS_CACHE_LINE_SIZE) std::atomic<uint32_t> tail;
+
+	// Number of slots - 1 (the number of slots is a power of 2), constant after init()
+	alignas(HAOS_CACHE_LINE_SIZE) uint32_t mask;
+} HAOS_BrickRing_t;
+
+// One brick of all IO channels with the state that travels with it
+typedef struct
+{
+	HAOS_CtrlFlags_t ctrlFlags;
+	HAOS_ChannelMask_t validChannels;	// valid channel mask of the producing core
+	HAOS_BrickBuffer_t data[NUMBER_OF_IO_CHANNELS];
+} HAOS_QueuedBrick_t;
+
+typedef struct
+{
+	HAOS_BrickRing_t ring;
+
+	alignas(HAOS_CACHE_LINE_SIZE) HAOS_QueuedBrick_t slots[HAOS_BRICK_QUEUE_SIZE];
+} HAOS_BrickQueue_t;
+
+namespace BrickRing
+{
+	static inline bool isValidSize(uint32_t size)
+	{
+		return size != 0 && (size & (size - 1)) == 0;
+	}
+
+	// size must be a power of 2, see isValidSize()
+	static inline void init(HAOS_BrickRing_t* ring, uint32_t size)
+	{
+		ring->mask = size - 1;
+		ring->head.store(0, std::memory_order_relaxed);
+		ring->tail.store(0, std::memory_order_relaxed);
+	}
+
+	// Number of bricks the consumer can read, called by the consumer
+	static inline uint32_t usedCnt(HAOS_BrickRing_t* ring)
+	{
+		return ring->head.load(std::memory_order_acquire) - ring->tail.load(std::memory_order_relaxed);
+	}
+
+	// Number of bricks the producer can write, called by the producer
+	static inline uint32_t freeCnt(HAOS_BrickRing_t* ring)
+	{
+		return ring->mask + 1 - (ring->head.load(std::memory_order_relaxed) - ring->tail.load(std::memory_order_acquire));
+	}
+
+	// Slot the producer writes the next brick to
+	static inline uint32_t writeSlot(HAOS_BrickRing_t* ring)
+	{
+		return ring->head.load(std::memory_order_relaxed) & ring->mask;
+	}
+
+	// Slot of the oldest brick, read by the consumer
+	static inline uint32_t readSlot(HAOS_BrickRing_t* ring)
+	{
+		return ring->tail.load(std::memory_order_relaxed) & ring->mask;
+	}
+
+	// Returns writeSlot(), waits while the ring is full
+	static inline uint32_t waitForFree(HAOS_BrickRing_t* ring)
+	{
+		while (freeCnt(ring) == 0)
+		{
+			std::this_thread::yield();
+		}
+
+		return writeSlot(ring);
+	}
+
+	// Returns readSlot(), waits while the ring is empty
+	static inline uint32_t waitForData(HAOS_BrickRing_t* ring)
+	{
+		while (usedCnt(ring) == 0)
+		{
+			std::this_thread::yield();
+		}
+
+		return readSlot(ring);
+	}
+
+	// Hands the brick in writeSlot() to the consumer
+	static inline void commitWrite(HAOS_BrickRing_t* ring)
+	{
+		ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Returns readSlot() to the producer
+	static inline void commitRead(HAOS_BrickRing_t* ring)
+	{
+		ring->tail.store(ring->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+}
+
+namespace BrickQueue
+{
+	static inline void init(HAOS_BrickQueue_t* queue)
+	{
+		BrickRing::init(&queue->ring, HAOS_BRICK_QUEUE_SIZE);
+	}
+
+	// Returns the slot for the next brick, waits while the queue is full
+	static inline HAOS_QueuedBrick_t* beginWrite(HAOS_BrickQueue_t* queue)
+	{
+		return &queue->slots[BrickRing::waitForFree(&queue->ring)];
+	}
+
+	// Hands the slot returned by beginWrite() to the consumer
+	static inline void endWrite(HAOS_BrickQueue_t* queue)
+	{
+		BrickRing::commitWrite(&queue->ring);
+	}
+
+	// Returns the oldest brick, waits while the queue is empty
+	static inline HAOS_QueuedBrick_t* beginRead(HAOS_BrickQueue_t* queue)
+	{
+		return &queue->slots[BrickRing::waitForData(&queue->ring)];
+	}
+
+	// Returns the slot returned by beginRead() to the producer
+	static inline void endRead(HAOS_BrickQueue_t* queue)
+	{
+		BrickRing::commitRead(&queue->ring);
+	}
+}
+
+#endif /* HAOS_BRICKQUEUE_H__ */
@@ -36,13 +36,21 @@
 #define MAX_HOST_COMMANDS_COUNT 	1024
 
 
-// Number of brick slots allocated per audio channel in the I/O buffer.
-// Used to implement circular buffering for block-based processing.
-#define IO_BUFFER_PER_CHAN_MODULO   4
+// Maximum number of host writes to MCV word ranges kept per module until its core applies them
+// and notifies the module (see HAOS_Mct_t::McvChanged). Adjacent writes for a brick share a range.
+#define MAX_MCV_CHANGED_RANGES		16
 
-// Total number of samples allocated per channel in the I/O buffer.
-// Computed as number of bricks per channel multiplied by samples per brick.
-#define IO_BUFFER_SIZE_PER_CHAN     BRICK_SIZE * IO_BUFFER_PER_CHAN_MODULO
+// Maximum number of words of one MCV write range (the payload of one host comm message)
+#define MAX_MCV_RANGE_WORDS		32
+
+
+// Default number of brick slots per audio channel in the I/O buffer.
+// The slots form a ring (see HAOS_BrickRing_t), the number must be a power of 2.
+// It can be changed at runtime (--iobricks).
+#define IO_BUFFER_BRICKS_DFLT       4
+
+// Max number of brick slots per audio channel, the static I/O buffers are allocated for it
+#define IO_BUFFER_BRICKS_MAX        64
 
 // Default channel mask for post-processing stage (PPM).
 // Bitmask enabling channel 0 and channel 2 (binary 00000101).
@@ -0,0 +1,379 @@
+/*
+ * haos_profiler.cpp
+ *
+ * Execution time profiler of the haOS simulator, see haos_profiler.h.
+ */
+
+#include "haos_profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+// Call durations are kept in a histogram with HIST_SUB_BUCKETS buckets per octave
+// (about 3 % resolution), exact below HIST_LINEAR ticks. p99 is taken from it.
+#define HIST_SUB_BITS		5
+#define HIST_SUB_BUCKETS	(1 << HIST_SUB_BITS)
+#define HIST_LINEAR			(2 * HIST_SUB_BUCKETS)
+#define HIST_OCTAVES		40
+#define HIST_BUCKETS		(HIST_LINEAR + HIST_OCTAVES * HIST_SUB_BUCKETS)
+
+namespace Profiler
+{
+	// Statistics of one entry point of one module
+	typedef struct
+	{
+		uint64_t calls;			// all calls
+		uint64_t timedCalls;	// measured calls
+		uint64_t totalTicks;	// sum of the measured calls
+		uint64_t minTicks;
+		uint64_t maxTicks;
+		uint32_t histogram[HIST_BUCKETS];
+	} Profiler_Entry_t;
+
+	// Statistics converted for the report; totals are extrapolated from the measured calls
+	typedef struct
+	{
+		uint64_t calls;
+		uint64_t timedCalls;
+		double minUs;
+		double meanUs;
+		double p99Us;
+		double maxUs;
+		double totalMs;
+		double mcps;			// million ticks per second of audio
+		double loadPercent;		// share of one host core at real time
+	} Profiler_Stats_t;
+
+	static const char* const entryPointNames[HAOS_ROUTINES_CNT] =
+	{
+		"Prekick", "Postkick", "Timer", "Frame", "Brick", "AFAP", "Background", "Postmalloc", "Premalloc",
+		"McvChanged"
+	};
+
+	// Allocated on the first call of an entry point, most modules implement only a few
+	static Profiler_Entry_t* entries[MAX_CORES_COUNT][MAX_MODULES_COUNT][HAOS_ROUTINES_CNT];
+
+	static bool active = false;
+	static uint32_t ratio = 1;
+	static uint32_t dispatchCnt[MAX_CORES_COUNT][HAOS_ROUTINES_CNT];
+
+	// Time base calibration
+	static uint64_t startTicks;
+	static uint64_t stopTicks;
+	static std::chrono::steady_clock::time_point startTime;
+	static std::chrono::steady_clock::time_point stopTime;
+	static double ticksPerSecond = 1e9;
+
+	static int bucketIndex(uint64_t ticks)
+	{
+		if (ticks < HIST_LINEAR)
+		{
+			return (int)ticks;
+		}
+
+		int shift = 0;
+		while (ticks >= HIST_LINEAR)
+		{
+			ticks >>= 1;
+			shift++;
+		}
+
+		if (shift > HIST_OCTAVES)
+		{
+			return HIST_BUCKETS - 1;
+		}
+
+		// ticks is in [HIST_SUB_BUCKETS, HIST_LINEAR) now
+		return HIST_LINEAR + (shift - 1) * HIST_SUB_BUCKETS + (int)(ticks - HIST_SUB_BUCKETS);
+	}
+
+	// Middle of the range covered by a bucket
+	static uint64_t bucketValue(int index)
+	{
+		if (index < HIST_LINEAR)
+		{
+			return index;
+		}
+
+		int shift = (index - HIST_LINEAR) / HIST_SUB_BUCKETS + 1;
+		uint64_t sub = (index - HIST_LINEAR) % HIST_SUB_BUCKETS + HIST_SUB_BUCKETS;
+
+		return (sub << shift) + (((uint64_t)1 << shift) >> 1);
+	}
+
+	static uint64_t percentile(const Profiler_Entry_t* pEntry, double fraction)
+	{
+		uint64_t rank = (uint64_t)(fraction * pEntry->timedCalls + 0.5);
+		if (rank < 1) rank = 1;
+
+		uint64_t count = 0;
+		for (int i = 0; i < HIST_BUCKETS; i++)
+		{
+			count += pEntry->histogram[i];
+			if (count >= rank)
+			{
+				uint64_t value = bucketValue(i);
+
+				// the bucket middle may lie outside of the measured range
+				if (value < pEntry->minTicks) value = pEntry->minTicks;
+				if (value > pEntry->maxTicks) value = pEntry->maxTicks;
+				return value;
+			}
+		}
+		return pEntry->maxTicks;
+	}
+
+	static bool getStats(int coreIdx, int moduleIdx, int entryPoint, double audioSeconds, Profiler_Stats_t* pStats)
+	{
+		const Profiler_Entry_t* pEntry = entries[coreIdx][moduleIdx][entryPoint];
+
+		if (pEntry == nullptr || pEntry->timedCalls == 0)
+		{
+			return false;
+		}
+
+		double usPerTick = 1e6 / ticksPerSecond;
+		double totalTicks = (double)pEntry->totalTicks * pEntry->calls / pEntry->timedCalls;
+
+		pStats->calls = pEntry->calls;
+		pStats->timedCalls = pEntry->timedCalls;
+		pStats->minUs = pEntry->minTicks * usPerTick;
+		pStats->meanUs = (double)pEntry->totalTicks / pEntry->timedCalls * usPerTick;
+		pStats->p99Us = percentile(pEntry, 0.99) * usPerTick;
+		pStats->maxUs = pEntry->maxTicks * usPerTick;
+		pStats->totalMs = totalTicks * usPerTick / 1e3;
+		pStats->mcps = audioSeconds > 0 ? totalTicks / audioSeconds / 1e6 : 0;
+		pStats->loadPercent = audioSeconds > 0 ? 100.0 * totalTicks / ticksPerSecond / audioSeconds : 0;
+
+		return true;
+	}
+
+	static std::string moduleName(const HAOS_OdtEntry_t* pOdtEntry)
+	{
+		if (pOdtEntry->name)
+		{
+			return pOdtEntry->name;
+		}
+
+		char name[16];
+		snprintf(name, sizeof(name), "0x%04x", pOdtEntry->moduleID);
+		return name;
+	}
+	//==============================================================================
+
+	void start(uint32_t sampleRatio)
+	{
+		for (int core = 0; core < MAX_CORES_COUNT; core++)
+		{
+			for (int module = 0; module < MAX_MODULES_COUNT; module++)
+			{
+				for (int entryPoint = 0; entryPoint < HAOS_ROUTINES_CNT; entryPoint++)
+				{
+					free(entries[core][module][entryPoint]);
+					entries[core][module][entryPoint] = nullptr;
+				}
+			}
+		}
+
+		memset(dispatchCnt, 0, sizeof(dispatchCnt));
+		ratio = sampleRatio ? sampleRatio : 1;
+		active = true;
+
+		startTime = std::chrono::steady_clock::now();
+		startTicks = now();
+	}
+	//==============================================================================
+
+	void stop()
+	{
+		if (!active)
+		{
+			return;
+		}
+
+		stopTicks = now();
+		stopTime = std::chrono::steady_clock::now();
+		active = false;
+
+		std::chrono::duration<double> elapsed = stopTime - startTime;
+
+#if HAOS_PROFILER_TSC
+		if (elapsed.count() > 0)
+		{
+			ticksPerSecond = (stopTicks - startTicks) / elapsed.count();
+		}
+#else
+		ticksPerSecond = 1e9;
+#endif
+	}
+	//==============================================================================
+
+	bool enabled()
+	{
+		return active;
+	}
+	//==============================================================================
+
+	bool sampleDispatch(int coreIdx, HAOS_ROUTINE entryPoint)
+	{
+		if (dispatchCnt[coreIdx][entryPoint]-- == 0)
+		{
+			dispatchCnt[coreIdx][entryPoint] = ratio - 1;
+			return true;
+		}
+		return false;
+	}
+	//==============================================================================
+
+	void record(int coreIdx, int moduleIdx, HAOS_ROUTINE entryPoint, bool timed, uint64_t ticks)
+	{
+		Profiler_Entry_t* pEntry = entries[coreIdx][moduleIdx][entryPoint];
+
+		if (pEntry == nullptr)
+		{
+			pEntry = (Profiler_Entry_t*)calloc(1, sizeof(Profiler_Entry_t));
+			if (pEntry == nullptr)
+			{
+				return;
+			}
+			pEntry->minTicks = UINT64_MAX;
+			entries[coreIdx][moduleIdx][entryPoint] = pEntry;
+		}
+
+		pEntry->calls++;
+
+		if (timed)
+		{
+			pEntry->timedCalls++;
+			pEntry->totalTicks += ticks;
+			if (ticks < pEntry->minTicks) pEntry->minTicks = ticks;
+			if (ticks > pEntry->maxTicks) pEntry->maxTicks = ticks;
+			pEntry->histogram[bucketIndex(ticks)]++;
+		}
+	}
+	//==============================================================================
+
+	void printReport(const HAOS_CoreTable_t coreTable, int coresNumber, double audioSeconds, uint32_t sampleRate)
+	{
+		char line[200];
+
+		printf(">>Profile: %.3f s of audio at %u Hz, time base %s %.1f MHz", audioSeconds, sampleRate,
+			HAOS_PROFILER_TSC ? "TSC" : "steady clock", ticksPerSecond / 1e6);
+		if (ratio > 1)
+		{
+			printf(", 1 in %u calls measured", ratio);
+		}
+		printf("\n");
+
+		snprintf(line, sizeof(line), "   %-4s %-14s %-10s %10s %9s %9s %9s %9s %10s %9s %7s",
+			"core", "module", "entry", "calls", "min us", "mean us", "p99 us", "max us", "total ms", "MCPS", "load %");
+		printf("%s\n", line);
+
+		for (int coreIdx = 0; coreIdx < coresNumber; coreIdx++)
+		{
+			const HAOS_Core_t* pCore = &coreTable[coreIdx];
+
+			for (uint32_t moduleIdx = 0; moduleIdx < pCore->modulesCnt; moduleIdx++)
+			{
+				std::string name = moduleName(&pCore->moduleMIFs[moduleIdx]);
+				double moduleMcps = 0;
+				double moduleLoad = 0;
+				int rows = 0;
+
+				for (int entryPoint = 0; entryPoint < HAOS_ROUTINES_CNT; entryPoint++)
+				{
+					Profiler_Stats_t stats;
+
+					if (!getStats(coreIdx, moduleIdx, entryPoint, audioSeconds, &stats)) continue;
+
+					snprintf(line, sizeof(line), "   %-4d %-14s %-10s %10llu %9.3f %9.3f %9.3f %9.3f %10.3f %9.3f %7.3f",
+						coreIdx, name.c_str(), entryPointNames[entryPoint], (unsigned long long)stats.calls,
+						stats.minUs, stats.meanUs, stats.p99Us, stats.maxUs, stats.totalMs, stats.mcps, stats.loadPercent);
+					printf("%s\n", line);
+
+					moduleMcps += stats.mcps;
+					moduleLoad += stats.loadPercent;
+					rows++;
+				}
+
+				if (rows)
+				{
+					snprintf(line, sizeof(line), "   %-4d %-14s %-10s %10s %9s %9s %9s %9s %10s %9.3f %7.3f",
+						coreIdx, name.c_str(), "total", "", "", "", "", "", "", moduleMcps, moduleLoad);
+					printf("%s\n", line);
+				}
+			}
+		}
+	}
+	//==============================================================================
+
+	bool writeJson(const std::string& filePath, const HAOS_CoreTable_t coreTable, int coresNumber,
+		double audioSeconds, uint32_t sampleRate)
+	{
+		FILE* file = fopen(filePath.c_str(), "w");
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		fprintf(file, "{\n");
+		fprintf(file, "  \"sampleRate\": %u,\n", sampleRate);
+		fprintf(file, "  \"brickSize\": %d,\n", BRICK_SIZE);
+		fprintf(file, "  \"audioSeconds\": %.6f,\n", audioSeconds);
+		fprintf(file, "  \"timeBase\": \"%s\",\n", HAOS_PROFILER_TSC ? "tsc" : "steady_clock");
+		fprintf(file, "  \"timeBaseMHz\": %.3f,\n", ticksPerSecond / 1e6);
+		fprintf(file, "  \"sampleRatio\": %u,\n", ratio);
+		fprintf(file, "  \"modules\": [");
+
+		const char* moduleSep = "";
+		for (int coreIdx = 0; coreIdx < coresNumber; coreIdx++)
+		{
+			const HAOS_Core_t* pCore = &coreTable[coreIdx];
+
+			for (uint32_t moduleIdx = 0; moduleIdx < pCore->modulesCnt; moduleIdx++)
+			{
+				double moduleMcps = 0;
+				double moduleLoad = 0;
+
+				fprintf(file, "%s\n    {\n", moduleSep);
+				fprintf(file, "      \"core\": %d,\n", coreIdx);
+				fprintf(file, "      \"name\": \"%s\",\n", moduleName(&pCore->moduleMIFs[moduleIdx]).c_str());
+				fprintf(file, "      \"moduleID\": %u,\n", pCore->moduleMIFs[moduleIdx].moduleID);
+				fprintf(file, "      \"entryPoints\": [");
+
+				const char* entrySep = "";
+				for (int entryPoint = 0; entryPoint < HAOS_ROUTINES_CNT; entryPoint++)
+				{
+					Profiler_Stats_t stats;
+
+					if (!getStats(coreIdx, moduleIdx, entryPoint, audioSeconds, &stats)) continue;
+
+					fprintf(file, "%s\n        { \"name\": \"%s\", \"calls\": %llu, \"timedCalls\": %llu, "
+						"\"minUs\": %.3f, \"meanUs\": %.3f, \"p99Us\": %.3f, \"maxUs\": %.3f, "
+						"\"totalMs\": %.3f, \"mcps\": %.3f, \"loadPercent\": %.4f }",
+						entrySep, entryPointNames[entryPoint],
+						(unsigned long long)stats.calls, (unsigned long long)stats.timedCalls,
+						stats.minUs, stats.meanUs, stats.p99Us, stats.maxUs,
+						stats.totalMs, stats.mcps, stats.loadPercent);
+
+					moduleMcps += stats.mcps;
+					moduleLoad += stats.loadPercent;
+					entrySep = ",";
+				}
+
+				fprintf(file, "\n      ],\n");
+				fprintf(file, "      \"mcps\": %.3f,\n", moduleMcps);
+				fprintf(file, "      \"loadPercent\": %.4f\n", moduleLoad);
+				fprintf(file, "    }");
+				moduleSep = ",";
+			}
+		}
+
+		fprintf(file, "\n  ]\n}\n");
+		fclose(file);
+
+		return true;
+	}
+	//==============================================================================
+}
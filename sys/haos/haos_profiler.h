@@ -0,0 +1,79 @@
+/*
+ * haos_profiler.h
+ *
+ * Execution time profiler of the haOS simulator. callAllModules() measures every
+ * MCT entry point call of every module; the profiler keeps min, mean, p99 and max
+ * per module and entry point and reports the load at the stream's sample rate.
+ */
+
+#ifndef HAOS_PROFILER_H__
+#define HAOS_PROFILER_H__
+
+#include "stdint.h"
+#include <string>
+#include "haos.h"
+
+// The x86 time stamp counter is read in a few ns; other hosts use the steady clock (ns)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAOS_PROFILER_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HAOS_PROFILER_TSC 1
+#else
+#include <chrono>
+#define HAOS_PROFILER_TSC 0
+#endif
+
+namespace Profiler
+{
+	// @brief Returns the current value of the profiler time base, in ticks.
+	//
+	// The ticks are TSC counts on x86 hosts and nanoseconds otherwise. They are converted
+	// to seconds with the tick rate measured between start() and stop().
+	static inline uint64_t now()
+	{
+#if HAOS_PROFILER_TSC
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	// @brief Clears all statistics and starts profiling.
+	//
+	// @param sampleRatio 1 to measure every call, N to measure only one in N dispatches
+	//                    of each entry point (the totals are extrapolated).
+	void start(uint32_t sampleRatio);
+
+	// @brief Stops profiling, the tick rate is calibrated against the steady clock here.
+	void stop();
+
+	// @return true between start() and stop().
+	bool enabled();
+
+	// @brief Decides whether the current dispatch of an entry point is measured.
+	//
+	// Called once per entry point dispatch (all modules of a core), before the first module.
+	// The statistics of a core are only updated by the thread running that core.
+	bool sampleDispatch(int coreIdx, HAOS_ROUTINE entryPoint);
+
+	// @brief Records one call of an entry point of a module.
+	//
+	// @param timed true if the call was measured, ticks is its duration then.
+	void record(int coreIdx, int moduleIdx, HAOS_ROUTINE entryPoint, bool timed, uint64_t ticks);
+
+	// @brief Prints the statistics of all profiled modules and entry points as a table.
+	//
+	// @param audioSeconds Duration of the processed audio, the load is relative to it.
+	void printReport(const HAOS_CoreTable_t coreTable, int coresNumber, double audioSeconds, uint32_t sampleRate);
+
+	// @brief Writes the same statistics as printReport() to a JSON file.
+	//
+	// @return true on success, false if the file can't be written.
+	bool writeJson(const std::string& filePath, const HAOS_CoreTable_t coreTable, int coresNumber,
+		double audioSeconds, uint32_t sampleRate);
+}
+
+#endif /* HAOS_PROFILER_H__ */
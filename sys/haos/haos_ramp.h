@@ -0,0 +1,145 @@
+/*
+ * haos_ramp.h
+ *
+ * Per-channel gain ramps for the brick functions of the post-processing modules.
+ *
+ * A module keeps one HAOS_GainRamp_t for the gains it applies. When the host writes
+ * a new gain to the MCV, the module hands it to setTarget() on its next brick and
+ * apply() moves the gain from its current value to the new one linearly over the
+ * ramp length, instead of switching it at a brick boundary (zipper noise). A channel
+ * that isn't ramping is scaled by a constant, or only copied if its gain is 1.
+ */
+
+#ifndef HAOS_RAMP_H__
+#define HAOS_RAMP_H__
+
+#include <string.h>
+#include "haos_api.h"
+
+// Default ramp length, in samples (5.3 ms at 48 kHz)
+#define HAOS_RAMP_LENGTH_DFLT		256
+
+typedef struct
+{
+	HAOS_PcmSample_t current[NUMBER_OF_IO_CHANNELS];	// gain at the end of the last brick
+	HAOS_PcmSample_t target[NUMBER_OF_IO_CHANNELS];		// gain at the end of the ramp
+	HAOS_PcmSample_t step[NUMBER_OF_IO_CHANNELS];		// gain change per sample
+	uint32_t remaining[NUMBER_OF_IO_CHANNELS];			// samples left until the target is reached
+	HAOS_ChannelMask_t rampMask;						// channels with a ramp in progress
+	uint32_t rampLength;								// length of new ramps, in samples (0: no ramps)
+} HAOS_GainRamp_t;
+
+namespace GainRamp
+{
+	// All channels start at gain without a ramp
+	static inline void init(HAOS_GainRamp_t* ramp, uint32_t rampLength, HAOS_PcmSample_t gain)
+	{
+		for (int ch = 0; ch < NUMBER_OF_IO_CHANNELS; ch++)
+		{
+			ramp->current[ch] = gain;
+			ramp->target[ch] = gain;
+			ramp->step[ch] = 0;
+			ramp->remaining[ch] = 0;
+		}
+
+		ramp->rampMask = 0;
+		ramp->rampLength = rampLength;
+	}
+
+	// Applies to the ramps started after the call, a ramp in progress keeps its length
+	static inline void setRampLength(HAOS_GainRamp_t* ramp, uint32_t rampLength)
+	{
+		ramp->rampLength = rampLength;
+	}
+
+	// Starts a ramp from the current gain of the channel to target; a ramp in progress
+	// is restarted from where it is. Nothing changes if target is already the target.
+	static inline void setTarget(HAOS_GainRamp_t* ramp, int ch, HAOS_PcmSample_t target)
+	{
+		if (target == ramp->target[ch])
+		{
+			return;
+		}
+
+		ramp->target[ch] = target;
+
+		if (ramp->rampLength == 0)
+		{
+			ramp->current[ch] = target;
+			ramp->remaining[ch] = 0;
+			ramp->rampMask &= ~(1U << ch);
+			return;
+		}
+
+		ramp->step[ch] = (target - ramp->current[ch]) / (HAOS_PcmSample_t)ramp->rampLength;
+		ramp->remaining[ch] = ramp->rampLength;
+		ramp->rampMask |= 1U << ch;
+	}
+
+	static inline bool isRamping(const HAOS_GainRamp_t* ramp, int ch)
+	{
+		return (ramp->rampMask & (1U << ch)) != 0;
+	}
+
+	// true if the channel is at gain 1 and not ramping, apply() only copies it then
+	static inline bool isUnity(const HAOS_GainRamp_t* ramp, int ch)
+	{
+		return !isRamping(ramp, ch) && ramp->current[ch] == 1;
+	}
+
+	// @brief Scales one brick of a channel by its gain and advances its ramp by BRICK_SIZE samples.
+	//
+	// Sample s of a ramp gets current + step * (s + 1), so the samples don't depend on each
+	// other and the loops vectorize. The last sample of a ramp gets the target exactly.
+	// src and dst may be the same brick.
+	static inline void apply(HAOS_GainRamp_t* ramp, int ch, const HAOS_PcmSample_t* src, HAOS_PcmSample_t* dst)
+	{
+		int sample = 0;
+
+		if (isRamping(ramp, ch))
+		{
+			HAOS_PcmSample_t start = ramp->current[ch];
+			HAOS_PcmSample_t step = ramp->step[ch];
+			bool rampEnds = ramp->remaining[ch] <= BRICK_SIZE;
+			int rampCnt = rampEnds ? ramp->remaining[ch] : BRICK_SIZE;
+
+			// the last sample of the ramp is scaled by the target below, the rounding
+			// of the steps is not carried over the end of the ramp
+			int stepCnt = rampEnds ? rampCnt - 1 : rampCnt;
+
+			for (; sample < stepCnt; sample++)
+			{
+				dst[sample] = src[sample] * (start + step * (HAOS_PcmSample_t)(sample + 1));
+			}
+
+			ramp->remaining[ch] -= rampCnt;
+			if (rampEnds)
+			{
+				ramp->current[ch] = ramp->target[ch];
+				ramp->rampMask &= ~(1U << ch);
+			}
+			else
+			{
+				ramp->current[ch] = start + step * (HAOS_PcmSample_t)rampCnt;
+			}
+		}
+
+		HAOS_PcmSample_t gain = ramp->current[ch];
+
+		if (gain == 1)
+		{
+			if (dst != src)
+			{
+				memcpy(&dst[sample], &src[sample], (BRICK_SIZE - sample) * sizeof(HAOS_PcmSample_t));
+			}
+			return;
+		}
+
+		for (; sample < BRICK_SIZE; sample++)
+		{
+			dst[sample] = src[sample] * gain;
+		}
+	}
+}
+
+#endif /* HAOS_RAMP_H__ */
@@ -9,6 +9,8 @@
 #include "bitripper_sim.h"
 #include "wavefile.h"
 #include "colormod.h"
+#include "haos_profiler.h"
+#include "haos_brickqueue.h"
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -16,6 +18,13 @@
 #include <list>
 #include <cmath>
 #include <iostream>
+#include <vector>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <map>
 
 #define VERSION_STRING "0.3.0"
 
@@ -36,7 +45,7 @@ namespace HAOS
 {
 	// static memory allocation
 	static uint32_t sharedInputFIFO[MAX_CORES_COUNT][MAX_FIFO_CNT][MAX_FIFO_SIZE] = { 0 }; // FIFO0 buffer - read input samples
-	static int32_t sharedIObuffer[MAX_CORES_COUNT][NUMBER_OF_IO_CHANNELS][IO_BUFFER_PER_CHAN_MODULO][BRICK_SIZE] = { 0 };
+	static HAOS_PcmSample_t sharedIObuffer[MAX_CORES_COUNT][NUMBER_OF_IO_CHANNELS][IO_BUFFER_BRICKS_MAX][BRICK_SIZE] = { 0 };
 
 	// @brief Global system context instance used by the HAOS runtime.
 	//
@@ -45,16 +54,81 @@ namespace HAOS
 	//
 	static HAOS_System_t haOS;
 
+	// Core whose modules are being called. Each core thread has its own.
+	static thread_local pHAOS_Core_t pActiveCore = nullptr;
+
+	// Bricks from core N to core N + 1 when the cores run on their own threads
+	static HAOS_BrickQueue_t coreQueues[MAX_CORES_COUNT - 1];
+	static std::thread coreThreads[MAX_CORES_COUNT];
+
+	// Number of cores called by the main loop: all of them during the initialization and
+	// with --sequential, only core 0 while the core threads run
+	static int mainLoopCoresCnt = 1;
+
+	// Guards the MCV changes of all cores: host comm adds them, each core takes its own
+	static std::mutex mcvChangesLock;
+
+	// Host comm messages for a frame ("# Frame: " section of a cfg file) or for a sample of the
+	// stream ("# Sample: "), sorted by position. Messages for the same position keep their order.
+	typedef std::multimap<uint64_t, std::vector<uint32_t>> HostCommQueue_t;
+	static HostCommQueue_t frameHostComm;
+	static HostCommQueue_t sampleHostComm;
+
+	// When the messages read from a cfg file are sent
+	enum HOSTCOMM_TIMING
+	{
+		HOSTCOMM_NOW,		// prekick for --cfg, at the next brick for --hostcomm
+		HOSTCOMM_AT_FRAME,
+		HOSTCOMM_AT_SAMPLE
+	};
+
+	// Section of a cfg file being read, timed messages are collected until the section ends
+	typedef struct
+	{
+		HOSTCOMM_TIMING timing;
+		uint64_t position;
+		std::vector<uint32_t> messages;
+	} CfgSection_t;
+
+	// Set by the SIGINT handler, stops the main loop so the output file can be closed
+	static volatile sig_atomic_t stopRequested = 0;
+
+	// In offline mode without --profile only one in HAOS_OFFLINE_PROFILE_RATIO dispatches of an
+	// entry point is timed, the counter reads would cost a noticeable part of the run. Prime, so the
+	// timed bricks don't always fall on the same position in the frame (fg2bg ratio).
+	#define HAOS_OFFLINE_PROFILE_RATIO	13
+
+	// Number of bricks written to the output during the run
+	static uint64_t outputBricksCnt = 0;
+
 	static void parseCmdLine(int argc, const char* argv[]);
 	static void makeCoresList();
 	static void addCoreModules(void* moduleList, pHAOS_Core_t pCore);
 	static void initCores();
 	static void callAllModules(HAOS_ROUTINE entryPoint);
+	static void callCoreModules(int coreIdx, HAOS_ROUTINE entryPoint);
+	static void startCoreThreads();
+	static void stopCoreThreads();
+	static void coreThread(int coreIdx);
+	static void sendBrickToNextCore(int coreIdx, HAOS_CtrlFlags_t ctrlFlags);
+	static bool callEntryPoint(pHAOS_OdtEntry_t mb, HAOS_ROUTINE entryPoint);
+	static void addMcvChange(uint32_t moduleID, const HAOS_McvRange_t* pWrite);
+	static void applyMcvRange(uint32_t* mcv, const HAOS_McvRange_t* pRange);
+	static void notifyMcvChanges(int coreIdx);
+	static void printThroughputReport(double wallSeconds);
+	static void reportProfile();
 	static void readPrekickConfigs();
+	static void readCfgFile(const std::string pathName, HAOS_HostCommQ_t message, uint32_t* msgCnt, CfgSection_t* section);
+	static void processHostComm(HAOS_HostCommQ_t messageQ, uint32_t msgCnt, bool applyNow = false);
+	static void applyTimedHostComm(HostCommQueue_t& queue, uint64_t position, const char* unit);
+	static void pollHostCommFile();
 	static void openInputFile();
 	static bool openOutputFile();
 	static void writeToFile();
 	static void flushFrameToFile();
+	static void closeOutputFile();
+	static void onSigint(int signal);
+	static void compareWithReference();
 	static void updatePtrs();
 	static void initSystemStruct();
 	static void usage(const char* programName);
@@ -81,6 +155,7 @@ namespace HAOS
 		std::cout << "Arch: x86 Lightweight Simulation" << std::endl;
 		std::cout << "OS: Windows 10/11" << std::endl;
 		std::cout << "Version: " << VERSION_STRING << std::endl;
+		std::cout << "Brick size: " << BRICK_SIZE << " samples" << std::endl;
 		std::cout << "----------------------------------------------------------------" << std::endl;
 
 		std::cout << yellow;
@@ -144,6 +219,18 @@ namespace HAOS
 	{
 		std::cout << yellow << ">>Running haOS" << def << std::endl;
 
+		std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+
+		// Measure the module entry points: every call with --profile, a sample of them for the offline summary
+		if (!haOS.profilePath.empty())
+		{
+			Profiler::start(1);
+		}
+		else if (haOS.offline)
+		{
+			Profiler::start(HAOS_OFFLINE_PROFILE_RATIO);
+		}
+
 		// Initialize I/O buffers, internal pointers, and bitripper states for all cores
 		initCores();
 		
@@ -164,11 +251,17 @@ namespace HAOS
 		// Execute time-based initialization (e.g., initial delay, timing sync)
 		callAllModules(TIMER);
 
+		// Ctrl+C stops the simulation after the current frame, the output file stays valid
+		std::signal(SIGINT, onSigint);
+
+		// Cores 1 .. N run on their own threads and process the bricks of core 0 as a pipeline
+		startCoreThreads();
+
 		// Main loop: runs until end-of-file is detected in the input stream
-		while (haOS.flushDataCnt)
+		while (haOS.flushDataCnt && !stopRequested)
 		{
 			/* If EOF is detected, process two additional dummy frames to flush the remaining data from the system */
-			if (haOS.inStream.ctrlFlags & HAOS_STREAM_END_OF_FILE_FLAG)
+			if (!haOS.inputEndHeld.load(std::memory_order_acquire) && (haOS.inStream.ctrlFlags & HAOS_STREAM_END_OF_FILE_FLAG))
 			{
 				haOS.flushDataCnt--;
 			}
@@ -176,14 +269,21 @@ namespace HAOS
 			// For each BRICK in the frame (depending on fg2bg ratio)
 			for (int brick = 0; brick < haOS.fg2bg_ratio; brick++)
 			{
+				// Send the host comm messages timed for a sample up to the start of this brick
+				applyTimedHostComm(sampleHostComm, haOS.coreTable[0].brickIdx * BRICK_SIZE, "sample");
+
 				// Execute any asynchronous frame-ahead processing (optional for some modules)
 				callAllModules(AFAP);
 
 				// Execute one frame if the frameTriggered flag is set
-				if (haOS.ctrlFlags & HAOS_FRAME_TRIGGERED_FLAG)
+				bool frameTriggered = (haOS.ctrlFlags & HAOS_FRAME_TRIGGERED_FLAG) != 0;
+				if (frameTriggered)
 				{
 					haOS.frameCounter++;
 
+					// Send the host comm messages timed for this frame
+					applyTimedHostComm(frameHostComm, haOS.frameCounter, "frame");
+
 					callAllModules(FRAME);
 					haOS.ctrlFlags &= HAOS_FRAME_TRIGGERED_CLR;
 				}
@@ -205,10 +305,18 @@ namespace HAOS
 
 
 				//if (haosSystem.ctrlFlags & HAOS_DECODING_STARTED_FLAG)
-				if (haOS.coreTable[0].IOfree < IO_BUFFER_SIZE_PER_CHAN)
+				if (BrickRing::usedCnt(&haOS.coreTable[0].IOring) > 0)
 				{
-					// Write current brick data to output stream/file
-					writeToFile();
+					if (mainLoopCoresCnt < haOS.coresNumber)
+					{
+						// Hand the brick to the next core
+						sendBrickToNextCore(0, frameTriggered ? HAOS_BRICK_FRAME_FLAG : 0);
+					}
+					else
+					{
+						// Write current brick data to output stream/file
+						writeToFile();
+					}
 
 					//flushFrameToFile();
 
@@ -218,14 +326,57 @@ namespace HAOS
 
 			}
 
+			// Read the commands the host has sent during this frame
+			if (!haOS.hostCommPath.empty())
+			{
+				pollHostCommFile();
+			}
+
 			// Execute background processing step for all modules
 			callAllModules(BACKGROUND);
 
 			// Flush buffered frame data to file so its visible during runtime
-			flushFrameToFile();
+			if (mainLoopCoresCnt == haOS.coresNumber)
+			{
+				flushFrameToFile();
+			}
 
 		}
 
+		// Let the other cores process the bricks in flight
+		stopCoreThreads();
+
+		if (stopRequested)
+		{
+			std::cout << yellow << ">>Interrupted" << def << std::endl;
+		}
+
+		if (!frameHostComm.empty() || !sampleHostComm.empty())
+		{
+			std::cout << yellow << ">>Host comm: " << frameHostComm.size() + sampleHostComm.size()
+				<< " timed message group(s) past the end of the stream were not sent" << def << std::endl;
+		}
+
+		bool profiled = Profiler::enabled();
+		Profiler::stop();
+
+		// Write the remaining data and the final header
+		closeOutputFile();
+
+		if (haOS.offline)
+		{
+			std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - runStart;
+			printThroughputReport(wallTime.count());
+		}
+
+		if (profiled)
+		{
+			reportProfile();
+		}
+
+		// Report the deviation of the output from the reference file (if provided)
+		compareWithReference();
+
 		std::cout << yellow;
 		std::cout << ">>Total frames: " << getFrameCounter() << std::endl;
 		std::cout << ">>Shutting down haOS" << std::endl;
@@ -234,59 +385,403 @@ namespace HAOS
 	//==============================================================================
 
 
+	// Calls an entry point of the cores run by the main loop (all of them before the core threads start)
 	static void callAllModules(HAOS_ROUTINE entryPoint)
 	{
-		for (int coreIdx = 0; coreIdx < haOS.coresNumber; coreIdx++)
+		for (int coreIdx = 0; coreIdx < mainLoopCoresCnt; coreIdx++)
 		{
-			pHAOS_Core_t pCore = &haOS.coreTable[coreIdx];
+			// The channels a core works on are the ones the previous core left valid
+			if (coreIdx > 0)
+			{
+				haOS.coreTable[coreIdx].HAOS_PPM_VALID_CHANNELS = haOS.coreTable[coreIdx - 1].HAOS_PPM_VALID_CHANNELS;
+			}
+
+			callCoreModules(coreIdx, entryPoint);
+		}
+	}
+	//==============================================================================
+
+	// Calls an entry point of all modules of one core, in ODT order
+	static void callCoreModules(int coreIdx, HAOS_ROUTINE entryPoint)
+	{
+		pHAOS_Core_t pCore = &haOS.coreTable[coreIdx];
+
+		pActiveCore = pCore;
+
+		// Modules see the host's MCV writes before their next foreground call
+		if (entryPoint != PREKICK && entryPoint != BACKGROUND && pCore->mcvChanged.load(std::memory_order_acquire))
+		{
+			notifyMcvChanges(coreIdx);
+		}
+
+		pHAOS_OdtEntry_t mb = pCore->moduleMIFs;
+
+		// The profiler measures each entry point call. The timestamps are chained,
+		// one counter read per call.
+		bool profiling = Profiler::enabled();
+		bool timed = profiling && Profiler::sampleDispatch(coreIdx, entryPoint);
+		uint64_t last = timed ? Profiler::now() : 0;
 
-			haOS.pActiveCore = pCore;
+		for (uint32_t moduleIdx = 0; moduleIdx < pCore->modulesCnt; moduleIdx++)
+		{
+			if (callEntryPoint(mb, entryPoint) && profiling)
+			{
+				uint64_t now = timed ? Profiler::now() : 0;
+
+				Profiler::record(coreIdx, moduleIdx, entryPoint, timed, now - last);
+				last = now;
+			}
+
+			mb++;
+		}
+	}
+	//==============================================================================
+
+	// @brief Starts one thread per core for cores 1 .. N (not with --sequential).
+	//
+	// Core 0 stays on the main thread and runs the decoder side of the main loop.
+	// Every brick it produces is sent to core 1, which runs its modules on it and sends
+	// it on to core 2, etc. The last core writes the bricks to the output file.
+	static void startCoreThreads()
+	{
+		if (haOS.sequential || haOS.coresNumber <= 1)
+		{
+			mainLoopCoresCnt = haOS.coresNumber;
+			return;
+		}
+
+		mainLoopCoresCnt = 1;
+
+		for (int coreIdx = 1; coreIdx < haOS.coresNumber; coreIdx++)
+		{
+			BrickQueue::init(&coreQueues[coreIdx - 1]);
+		}
+
+		for (int coreIdx = 1; coreIdx < haOS.coresNumber; coreIdx++)
+		{
+			coreThreads[coreIdx] = std::thread(coreThread, coreIdx);
+		}
+	}
+	//==============================================================================
+
+	// Sends the end marker down the pipeline and waits until all core threads are done
+	static void stopCoreThreads()
+	{
+		if (mainLoopCoresCnt == haOS.coresNumber)
+		{
+			return;
+		}
+
+		sendBrickToNextCore(0, HAOS_BRICK_END_FLAG);
+
+		for (int coreIdx = 1; coreIdx < haOS.coresNumber; coreIdx++)
+		{
+			coreThreads[coreIdx].join();
+		}
 
-			pHAOS_OdtEntry_t mb = pCore->moduleMIFs;
+		mainLoopCoresCnt = haOS.coresNumber;
+	}
+	//==============================================================================
+
+	// Copies the current brick of a core (valid IO channels) to the queue of the next core
+	static void sendBrickToNextCore(int coreIdx, HAOS_CtrlFlags_t ctrlFlags)
+	{
+		pHAOS_Core_t pCore = &haOS.coreTable[coreIdx];
+		HAOS_BrickQueue_t* pQueue = &coreQueues[coreIdx];
+		HAOS_QueuedBrick_t* pBrick = BrickQueue::beginWrite(pQueue);
 
-			for (int moduleIdx = 0; moduleIdx < pCore->modulesCnt; moduleIdx++)
+		pBrick->ctrlFlags = ctrlFlags;
+		pBrick->validChannels = pCore->HAOS_PPM_VALID_CHANNELS;
+
+		if (!(ctrlFlags & HAOS_BRICK_END_FLAG))
+		{
+			for (HAOS_ChannelMask_t chMask = pBrick->validChannels; chMask != 0; chMask &= chMask - 1)
 			{
-				HAOS_Mct_t* HAOS_mctPtr = mb->MIF->MCT;
+				int32_t ch = HAOS_lowestChannel(chMask);
+				memcpy(pBrick->data[ch], pCore->HAOS_IOBUFFER_PTRS[ch], sizeof(HAOS_BrickBuffer_t));
+			}
+		}
 
-				if (!HAOS_mctPtr) continue;
+		BrickQueue::endWrite(pQueue);
+	}
+	//==============================================================================
+
+	// @brief Main loop of cores 1 .. N.
+	//
+	// Waits for the bricks of the previous core and calls the AFAP, FRAME (when the brick
+	// comes with a new frame) and BRICK entry points for each of them, and BACKGROUND once
+	// per fg2bg_ratio bricks. The core works on brick 0 of its own IOBUFFER.
+	static void coreThread(int coreIdx)
+	{
+		pHAOS_Core_t pCore = &haOS.coreTable[coreIdx];
+		HAOS_BrickQueue_t* pInQueue = &coreQueues[coreIdx - 1];
+		bool lastCore = (coreIdx == haOS.coresNumber - 1);
+		int brickCnt = 0;
+
+		pActiveCore = pCore;
+
+		while (true)
+		{
+			HAOS_QueuedBrick_t* pBrick = BrickQueue::beginRead(pInQueue);
+			HAOS_CtrlFlags_t ctrlFlags = pBrick->ctrlFlags;
 
-				switch (entryPoint)
+			if (ctrlFlags & HAOS_BRICK_END_FLAG)
+			{
+				BrickQueue::endRead(pInQueue);
+				if (!lastCore)
 				{
-				case PREKICK:
-					if (HAOS_mctPtr->Prekick) HAOS_mctPtr->Prekick(mb->MIF);
-					break;
-				case POSTKICK:
-					if (HAOS_mctPtr->Postkick) HAOS_mctPtr->Postkick();
-					break;
-				case TIMER:
-					if (HAOS_mctPtr->Timer) HAOS_mctPtr->Timer();
-					break;
-				case FRAME:
-					if (HAOS_mctPtr->Frame) HAOS_mctPtr->Frame();
-					break;
-				case BRICK:
-					if (HAOS_mctPtr->Brick) HAOS_mctPtr->Brick();
-					break;
-				case AFAP:
-					if (HAOS_mctPtr->AFAP) HAOS_mctPtr->AFAP();
-					break;
-				case BACKGROUND:
-					if (HAOS_mctPtr->Background) HAOS_mctPtr->Background();
-					break;
-				case POSTMALLOC:
-					if (HAOS_mctPtr->Postmalloc) HAOS_mctPtr->Postmalloc();
-					break;
-				case PREMALLOC:
-					if (HAOS_mctPtr->Premalloc) HAOS_mctPtr->Premalloc();
-					break;
+					sendBrickToNextCore(coreIdx, HAOS_BRICK_END_FLAG);
 				}
+				break;
+			}
 
-				mb++;
+			pCore->HAOS_PPM_VALID_CHANNELS = pBrick->validChannels;
+			for (HAOS_ChannelMask_t chMask = pBrick->validChannels; chMask != 0; chMask &= chMask - 1)
+			{
+				int32_t ch = HAOS_lowestChannel(chMask);
+				memcpy(pCore->HAOS_IOBUFFER_PTRS[ch], pBrick->data[ch], sizeof(HAOS_BrickBuffer_t));
+			}
+			BrickQueue::endRead(pInQueue);
+
+			callCoreModules(coreIdx, AFAP);
+
+			if (ctrlFlags & HAOS_BRICK_FRAME_FLAG)
+			{
+				callCoreModules(coreIdx, FRAME);
+			}
+
+			callCoreModules(coreIdx, BRICK);
+
+			if (lastCore)
+			{
+				writeToFile();
+			}
+			else
+			{
+				sendBrickToNextCore(coreIdx, ctrlFlags);
+			}
+
+			pCore->brickIdx++;
+
+			if (++brickCnt == haOS.fg2bg_ratio)
+			{
+				brickCnt = 0;
+
+				callCoreModules(coreIdx, BACKGROUND);
+
+				if (lastCore)
+				{
+					flushFrameToFile();
+				}
+			}
+		}
+	}
+	//==============================================================================
+
+	// Writes the MCV words the host has written for the bricks up to the current one to the
+	// modules of a core and calls their McvChanged entry point for them. Runs on the thread of
+	// the core, between two bricks, so the MCV of a module is only ever written by its own core.
+	static void notifyMcvChanges(int coreIdx)
+	{
+		pHAOS_Core_t pCore = &haOS.coreTable[coreIdx];
+
+		std::lock_guard<std::mutex> lock(mcvChangesLock);
+
+		bool timed = Profiler::enabled() && Profiler::sampleDispatch(coreIdx, MCV_CHANGED);
+		bool pending = false;
+
+		for (uint32_t moduleIdx = 0; moduleIdx < pCore->modulesCnt; moduleIdx++)
+		{
+			HAOS_McvChanges_t* pChanges = &pCore->mcvChanges[moduleIdx];
+			HAOS_Mct_t* HAOS_mctPtr = pCore->moduleMIFs[moduleIdx].MIF->MCT;
+			uint32_t* mcv = (uint32_t*)pCore->moduleMIFs[moduleIdx].MIF->MCV;
+			bool notify = HAOS_mctPtr && HAOS_mctPtr->McvChanged;
+			uint64_t start = timed ? Profiler::now() : 0;
+			uint32_t keptCnt = 0;
+
+			if (pChanges->rangesCnt == 0)
+			{
+				continue;
+			}
+
+			// all the writes due are in the MCV before the module sees the first of them
+			for (uint32_t idx = 0; idx < pChanges->rangesCnt; idx++)
+			{
+				if (pChanges->ranges[idx].brick <= pCore->brickIdx)
+				{
+					applyMcvRange(mcv, &pChanges->ranges[idx]);
+				}
+			}
+
+			// the writes made for a later brick are kept until the core gets to it
+			for (uint32_t idx = 0; idx < pChanges->rangesCnt; idx++)
+			{
+				HAOS_McvRange_t* pRange = &pChanges->ranges[idx];
+
+				if (pRange->brick > pCore->brickIdx)
+				{
+					pChanges->ranges[keptCnt++] = *pRange;
+				}
+				else if (notify)
+				{
+					HAOS_mctPtr->McvChanged(pRange->offset, pRange->wordCnt);
+				}
+			}
+
+			if (notify && keptCnt < pChanges->rangesCnt && Profiler::enabled())
+			{
+				Profiler::record(coreIdx, moduleIdx, MCV_CHANGED, timed, timed ? Profiler::now() - start : 0);
+			}
+
+			pChanges->rangesCnt = keptCnt;
+			pending |= keptCnt > 0;
+		}
+
+		pCore->mcvChanged.store(pending, std::memory_order_relaxed);
+	}
+	//==============================================================================
+
+	// Writes the values of an MCV write range to the words of a module's MCV
+	static void applyMcvRange(uint32_t* mcv, const HAOS_McvRange_t* pRange)
+	{
+		for (uint32_t idx = 0; idx < pRange->wordCnt; idx++)
+		{
+			switch (pRange->op)
+			{
+			case HAOS_MCV_WRITE:
+				mcv[pRange->offset + idx] = pRange->values[idx];
+				break;
+			case HAOS_MCV_OR:
+				mcv[pRange->offset + idx] |= pRange->values[idx];
+				break;
+			case HAOS_MCV_AND:
+				mcv[pRange->offset + idx] &= pRange->values[idx];
+				break;
+			case HAOS_MCV_APPLIED:
+				return;
+			}
+		}
+	}
+	//==============================================================================
+
+	// Queues a host write to the MCV of the module with the given ID and flags its core. The
+	// write is for the brick core 0 is about to process. A plain write for the same brick next to
+	// or over the last range is merged into it, as long as the result fits a range. Writes that
+	// are already applied only extend the notified range, also when all ranges are used.
+	static void addMcvChange(uint32_t moduleID, const HAOS_McvRange_t* pWrite)
+	{
+		for (int coreIdx = 0; coreIdx < haOS.coresNumber; coreIdx++)
+		{
+			pHAOS_Core_t pCore = &haOS.coreTable[coreIdx];
+
+			for (uint32_t moduleIdx = 0; moduleIdx < pCore->modulesCnt; moduleIdx++)
+			{
+				if (pCore->moduleMIFs[moduleIdx].moduleID != moduleID)
+				{
+					continue;
+				}
+
+				std::lock_guard<std::mutex> lock(mcvChangesLock);
+
+				HAOS_McvChanges_t* pChanges = &pCore->mcvChanges[moduleIdx];
+				HAOS_McvRange_t* pLast = pChanges->rangesCnt ? &pChanges->ranges[pChanges->rangesCnt - 1] : nullptr;
+				uint64_t brick = haOS.coreTable[0].brickIdx;
+				uint32_t end = pWrite->offset + pWrite->wordCnt;
+				uint32_t first = pLast && pLast->offset < pWrite->offset ? pLast->offset : pWrite->offset;
+				uint32_t lastEnd = pLast ? pLast->offset + pLast->wordCnt : 0;
+				uint32_t unionEnd = end > lastEnd ? end : lastEnd;
+				bool touching = pLast && pWrite->offset <= lastEnd && end >= pLast->offset;
+
+				if (pLast && pWrite->op == HAOS_MCV_APPLIED && pLast->op == HAOS_MCV_APPLIED &&
+					(pChanges->rangesCnt == MAX_MCV_CHANGED_RANGES || (pLast->brick == brick && touching)))
+				{
+					// the words are in the MCV already, the module is notified of the union
+					pLast->offset = first;
+					pLast->wordCnt = unionEnd - first;
+					pLast->brick = brick;
+				}
+				else if (pLast && pWrite->op == HAOS_MCV_WRITE && pLast->op == HAOS_MCV_WRITE &&
+					pLast->brick == brick && touching && unionEnd - first <= MAX_MCV_RANGE_WORDS)
+				{
+					// the later write wins for the words both ranges cover
+					memmove(&pLast->values[pLast->offset - first], pLast->values, pLast->wordCnt * sizeof(uint32_t));
+					memcpy(&pLast->values[pWrite->offset - first], pWrite->values, pWrite->wordCnt * sizeof(uint32_t));
+					pLast->offset = first;
+					pLast->wordCnt = unionEnd - first;
+				}
+				else if (pChanges->rangesCnt < MAX_MCV_CHANGED_RANGES)
+				{
+					pChanges->ranges[pChanges->rangesCnt] = *pWrite;
+					pChanges->ranges[pChanges->rangesCnt].brick = brick;
+					pChanges->rangesCnt++;
+				}
+				else
+				{
+					std::cerr << "Too many MCV writes pending for module 0x" << std::hex << moduleID << std::dec
+						<< ", the write of " << pWrite->wordCnt << " words at offset " << pWrite->offset << " is dropped" << std::endl;
+					return;
+				}
+
+				pCore->mcvChanged.store(true, std::memory_order_release);
+				return;
 			}
 		}
 	}
 	//==============================================================================
 
+	// Calls one MCT entry point of a module. Returns false if the module doesn't implement it.
+	static bool callEntryPoint(pHAOS_OdtEntry_t mb, HAOS_ROUTINE entryPoint)
+	{
+		HAOS_Mct_t* HAOS_mctPtr = mb->MIF->MCT;
+
+		if (!HAOS_mctPtr) return false;
+
+		switch (entryPoint)
+		{
+		case PREKICK:
+			if (!HAOS_mctPtr->Prekick) return false;
+			HAOS_mctPtr->Prekick(mb->MIF);
+			break;
+		case POSTKICK:
+			if (!HAOS_mctPtr->Postkick) return false;
+			HAOS_mctPtr->Postkick();
+			break;
+		case TIMER:
+			if (!HAOS_mctPtr->Timer) return false;
+			HAOS_mctPtr->Timer();
+			break;
+		case FRAME:
+			if (!HAOS_mctPtr->Frame) return false;
+			HAOS_mctPtr->Frame();
+			break;
+		case BRICK:
+			if (!HAOS_mctPtr->Brick) return false;
+			HAOS_mctPtr->Brick();
+			break;
+		case AFAP:
+			if (!HAOS_mctPtr->AFAP) return false;
+			HAOS_mctPtr->AFAP();
+			break;
+		case BACKGROUND:
+			if (!HAOS_mctPtr->Background) return false;
+			HAOS_mctPtr->Background();
+			break;
+		case POSTMALLOC:
+			if (!HAOS_mctPtr->Postmalloc) return false;
+			HAOS_mctPtr->Postmalloc();
+			break;
+		case PREMALLOC:
+			if (!HAOS_mctPtr->Premalloc) return false;
+			HAOS_mctPtr->Premalloc();
+			break;
+		default:
+			return false;
+		}
+
+		return true;
+	}
+	//==============================================================================
+
 	/**
  * @brief Initializes the list of cores used in the current concurrency context.
  *
@@ -296,7 +791,7 @@ namespace HAOS
  */
 	static void makeCoresList()
 	{
-		memset(haOS.coreTable, 0, sizeof(HAOS_CoreTable_t));
+		memset((void*)haOS.coreTable, 0, sizeof(HAOS_CoreTable_t));
 
 		// Loop through the number of active cores defined in haosSystem.coresNumber
 		for (int idx = 0; idx < haOS.coresNumber; idx++)
@@ -304,7 +799,7 @@ namespace HAOS
 			// Create a new core instance and assign its ID
 			HAOS_Core_t* pCore = &haOS.coreTable[idx];
 
-			haOS.pActiveCore = pCore;
+			pActiveCore = pCore;
 
 			pCore->coreID = idx;
 
@@ -312,9 +807,9 @@ namespace HAOS
 			memset(pCore->moduleMIFs, 0, sizeof(HAOS_ModuleTable_t));
 			pCore->modulesCnt = 0;
 
-			// Assign the shared static I/O buffer to current core
-			// All cores point to the same global I/O buffer
-			pCore->IOBUFFER = (HAOS_BrickBuffer_t(*)[IO_BUFFER_PER_CHAN_MODULO]) sharedIObuffer[0];
+			// Each core has its own I/O buffer; the bricks are copied from core to core.
+			// With --sequential all cores work in place on the I/O buffer of core 0.
+			pCore->IOBUFFER = (HAOS_BrickBuffer_t(*)[IO_BUFFER_BRICKS_MAX]) sharedIObuffer[haOS.sequential ? 0 : idx];
 
 			// Assign the input FIFO buffer only to core 0; others receive nullptr
 			//static_cast<bitripper::BitRipperState_t*>(core.bitRipper)->inputFIFO = (idx == 0) ? inputFIFO : nullptr;
@@ -381,7 +876,7 @@ namespace HAOS
 	//
 	// This function performs one-time setup for each core defined in haosSystem.coreTable.
 	// It clears I/O buffer memory, initializes input/output buffer pointers for each channel,
-	// sets the available free-space counter (IOfree), applies the default post-processing
+	// empties the I/O brick ring (IOring), applies the default post-processing
 	// channel mask (HAOS_PPM_VALID_CHANNELS), and initializes the BitRipper state.
 	//
 	// Should be called once during system initialization, before any processing begins.
@@ -395,16 +890,16 @@ namespace HAOS
 		{
 			pHAOS_Core_t pCore = &haOS.coreTable[coreIdx];
 
-			haOS.pActiveCore = pCore;
+			pActiveCore = pCore;
 
 			// Get raw pointer to the beginning of the I/O buffer for this core
 			HAOS_PcmSamplePtr_t ioBufferPtr = (HAOS_PcmSamplePtr_t)pCore->IOBUFFER;
 
 			// Size of one channel's I/O buffer (all its bricks)
-			int32_t chChunkSize = IO_BUFFER_PER_CHAN_MODULO * sizeof(HAOS_BrickBuffer_t);
+			int32_t chChunkSize = IO_BUFFER_BRICKS_MAX * sizeof(HAOS_BrickBuffer_t);
 
-			// Set initial free-space value per channel (in samples)
-			pCore->IOfree = IO_BUFFER_SIZE_PER_CHAN;
+			// All bricks of the I/O buffer are free
+			BrickRing::init(&pCore->IOring, haOS.ioBricks);
 
 			// Initialize I/O pointers for each channel
 			for (int i = 0; i < NUMBER_OF_IO_CHANNELS; ++i)
@@ -412,14 +907,20 @@ namespace HAOS
 				// Clear buffer memory for this channel
 				memset(ioBufferPtr, 0, chChunkSize);
 
-				// Set IO pointers to the start of the channel's buffer
-				pCore->HAOS_IOBUFFER_INP_PTRS[i] = ioBufferPtr;
-				pCore->HAOS_IOBUFFER_PTRS[i] = ioBufferPtr;
+				// Set the pointers to each brick of the channel's buffer
+				for (int brick = 0; brick < IO_BUFFER_BRICKS_MAX; brick++)
+				{
+					pCore->IOBUFFER_BRICK_PTRS[brick][i] = ioBufferPtr + brick * BRICK_SIZE;
+				}
 
 				// Move to the next channel's buffer location
-				ioBufferPtr += IO_BUFFER_PER_CHAN_MODULO * BRICK_SIZE;
+				ioBufferPtr += IO_BUFFER_BRICKS_MAX * BRICK_SIZE;
 			}
 
+			// Set IO pointers to the first brick
+			pCore->HAOS_IOBUFFER_INP_PTRS = pCore->IOBUFFER_BRICK_PTRS[0];
+			pCore->HAOS_IOBUFFER_PTRS = pCore->IOBUFFER_BRICK_PTRS[0];
+
 			// Set the default valid channel mask for post-processing
 			pCore->HAOS_PPM_VALID_CHANNELS = DEFAULT_PPM_CHANNEL_MASK;
 
@@ -428,12 +929,15 @@ namespace HAOS
 			/* This is for kickstart - for first switchInputFIFO() call after Init to work properly */
 			Core::initBitripper(0);
 		}
+
+		// The initialization entry points of all cores are called from the main thread
+		mainLoopCoresCnt = haOS.coresNumber;
 	}
 	//==============================================================================
 
 	HAOS_PcmSamplePtr_t* getIOChannelPointerTable()
 	{
-		return haOS.pActiveCore->HAOS_IOBUFFER_PTRS;
+		return pActiveCore->HAOS_IOBUFFER_PTRS;
 	}
 	//==============================================================================
 
@@ -459,6 +963,12 @@ namespace HAOS
 	}
 	//==============================================================================
 
+	bool getOfflineMode()
+	{
+		return haOS.offline;
+	}
+	//==============================================================================
+
 	int32_t getInputStreamFS()
 	{
 		return haOS.inStream.samplingFrequency;
@@ -473,14 +983,14 @@ namespace HAOS
 
 	HAOS_ChannelMask_t getValidChannelMask()
 	{
-		return haOS.pActiveCore->HAOS_PPM_VALID_CHANNELS;
+		return pActiveCore->HAOS_PPM_VALID_CHANNELS;
 	}
 	//==============================================================================
 
 	bool isActiveChannel(int32_t chIdx)
 	{
 		bool retValue = false;
-		if (haOS.pActiveCore->HAOS_PPM_VALID_CHANNELS & (1U << chIdx))
+		if (pActiveCore->HAOS_PPM_VALID_CHANNELS & (1U << chIdx))
 			retValue = true;
 
 		return retValue;
@@ -489,19 +999,31 @@ namespace HAOS
 
 	void setValidChannelMask(HAOS_ChannelMask_t newMask)
 	{
-		haOS.pActiveCore->HAOS_PPM_VALID_CHANNELS = newMask;
+		pActiveCore->HAOS_PPM_VALID_CHANNELS = newMask;
 	}
 	//==============================================================================
 
 	void* getActiveCore()
 	{
-		return (void*)haOS.pActiveCore;
+		return (void*)pActiveCore;
 	}
 	//==============================================================================
 
 	void* getActiveCoreBitRipper()
 	{
-		return (void*)haOS.pActiveCore->pBitRipper;
+		return (void*)pActiveCore->pBitRipper;
+	}
+	//==============================================================================
+
+	void setActiveCore(void* pCore)
+	{
+		pActiveCore = (pHAOS_Core_t)pCore;
+	}
+	//==============================================================================
+
+	void holdInputStreamEnd(bool hold)
+	{
+		haOS.inputEndHeld.store(hold, std::memory_order_release);
 	}
 	//==============================================================================
 
@@ -556,10 +1078,10 @@ namespace HAOS
 		haOS.coresNumber = NUMBER_OF_CORES;
 
 		// Set the foreground-to-background brick processing ratio (e.g., 16 bricks per frame)
-		haOS.fg2bg_ratio = 16;
+		haOS.fg2bg_ratio = HAOS_PCM_FRAME_SIZE / BRICK_SIZE;
 
 		// Assign pointers to globally shared I/O and FIFO buffers
-		haOS.systemIObuffers = (int32_t*)sharedIObuffer;
+		haOS.systemIObuffers = (HAOS_PcmSample_t*)sharedIObuffer;
 		haOS.systemFIFObuffers = (uint32_t*)sharedInputFIFO;
 
 		// Clear the content of the shared I/O buffer
@@ -568,9 +1090,8 @@ namespace HAOS
 		// Clear the content of the shared input FIFO buffer
 		memset(sharedInputFIFO, 0, sizeof(sharedInputFIFO));
 
-		// Initialize read and write brick counters
-		haOS.readBrickCnt = 0;
-		haOS.writeBrickCnt = 0;
+		// Number of bricks of the I/O buffer rings
+		haOS.ioBricks = IO_BUFFER_BRICKS_DFLT;
 
 		// Clear the all control flags
 		haOS.ctrlFlags = HAOS_CLEAR_ALL_FLAGS;
@@ -592,6 +1113,18 @@ namespace HAOS
 
 		/* Initialize flush frame counter */
 		haOS.flushDataCnt = HAOS_FLUSH_FRAMES_CNT_DFLT;
+
+		/* No decoder holds the end of the input stream */
+		haOS.inputEndHeld.store(false, std::memory_order_relaxed);
+
+		/* Output file header update interval */
+		haOS.outUpdateInterval = HAOS_OUTPUT_UPDATE_INTERVAL_DFLT;
+
+		/* Real-time simulation by default */
+		haOS.offline = false;
+
+		/* One thread per core */
+		haOS.sequential = false;
 	}
 
 	static void parseCmdLine(int argc, const char* argv[])
@@ -600,6 +1133,9 @@ namespace HAOS
 		programName.erase(0, programName.find_last_of("\\/") + 1);
 		std::string arg;
 
+		// --fg2bg wins over the MP3 frame default of --app, in either order
+		bool fg2bgSet = false;
+
 		if (argc <= 1)
 		{
 			usage(programName.c_str());
@@ -629,6 +1165,7 @@ namespace HAOS
 				{
 					std::istringstream is(argv[i++]);
 					is >> haOS.fg2bg_ratio;
+					fg2bgSet = true;
 				}
 				else
 				{
@@ -648,17 +1185,32 @@ namespace HAOS
 					exit(1);
 				}
 			}
+			else if (arg.find("--hostcomm") == 0)
+			{
+				if (i < argc)
+				{
+					haOS.hostCommPath = argv[i++];
+				}
+				else
+				{
+					usage(programName.c_str());
+					exit(1);
+				}
+			}
 			else if (arg.find("--app") == 0)
 			{
 				if (i < argc)
 				{
 					std::istringstream is(argv[i++]);
 					is >> useMp3;
-					if(arg.find("--fg2bg") != 0)
+					if (!fg2bgSet)
 					{
-						haOS.fg2bg_ratio = 72;
+						haOS.fg2bg_ratio = HAOS_MP3_FRAME_SIZE / BRICK_SIZE;
 					}
 
+					// The MP3 decoder checks the brick size at postkick, with decode-ahead it may
+					// not divide the frame
+
 				}
 				else
 				{
@@ -666,11 +1218,12 @@ namespace HAOS
 					exit(1);
 				}
 			}
-			else if (arg.find("--input") == 0)
+			else if (arg.find("--oupdate") == 0)
 			{
 				if (i < argc)
 				{
-					haOS.inStream.filePath = argv[i++];
+					std::istringstream is(argv[i++]);
+					is >> haOS.outUpdateInterval;
 				}
 				else
 				{
@@ -678,7 +1231,73 @@ namespace HAOS
 					exit(1);
 				}
 			}
-			else if (arg.find("--output") == 0)
+			else if (arg.find("--iobricks") == 0)
+			{
+				if (i < argc)
+				{
+					std::istringstream is(argv[i++]);
+					is >> haOS.ioBricks;
+
+					if (!BrickRing::isValidSize(haOS.ioBricks) || haOS.ioBricks > IO_BUFFER_BRICKS_MAX)
+					{
+						std::cerr << "--iobricks must be a power of 2 up to " << IO_BUFFER_BRICKS_MAX << std::endl;
+						exit(1);
+					}
+				}
+				else
+				{
+					usage(programName.c_str());
+					exit(1);
+				}
+			}
+			else if (arg.find("--offline") == 0)
+			{
+				haOS.offline = true;
+
+				// plain text, the output of batch runs goes to log files
+				Color::Modifier::enabled() = false;
+			}
+			else if (arg.find("--sequential") == 0)
+			{
+				haOS.sequential = true;
+			}
+			else if (arg.find("--profile") == 0)
+			{
+				if (i < argc)
+				{
+					haOS.profilePath = argv[i++];
+				}
+				else
+				{
+					usage(programName.c_str());
+					exit(1);
+				}
+			}
+			else if (arg.find("--ref") == 0)
+			{
+				if (i < argc)
+				{
+					haOS.refPath = argv[i++];
+				}
+				else
+				{
+					usage(programName.c_str());
+					exit(1);
+				}
+			}
+			else if (arg.find("--input") == 0)
+			{
+				if (i < argc)
+				{
+					haOS.inStream.filePath = argv[i++];
+				}
+				else
+				{
+					usage(programName.c_str());
+					exit(1);
+				}
+			}
+			else if (arg.find("--output") == 0)
 			{
 				if (i < argc)
 				{
@@ -811,7 +1430,12 @@ namespace HAOS
 		{
 			haOS.outStream.channelCount = calcChCntBasedOnChMask(HAOS::getValidChannelMask());
 			haOS.outStream.samplingFrequency = haOS.inStream.samplingFrequency;
-			haOS.outStream.bitsPerSample = haOS.inStream.bitsPerSample;
+
+			// a PCM input sets the output sample size, a bitstream keeps --osamplesize
+			if (haOS.inStream.type == DECODE_INFO_PCM)
+			{
+				haOS.outStream.bitsPerSample = haOS.inStream.bitsPerSample;
+			}
 
 			if (cl_wavwrite_open(
 				const_cast<char*>(haOS.outStream.filePath.c_str()),
@@ -824,6 +1448,20 @@ namespace HAOS
 				exit(1);
 			}
 
+			// Batch rendering: fewer, larger writes
+			if (haOS.offline)
+			{
+				cl_wavwrite_set_buffer_size(haOS.outStream.fileHandle, 1024 * 1024);
+			}
+
+			// Leave a valid output file also when exiting early (e.g. exit() on an error)
+			static bool closeAtExit = false;
+			if (!closeAtExit)
+			{
+				std::atexit(closeOutputFile);
+				closeAtExit = true;
+			}
+
 			return true;
 		}
 
@@ -839,28 +1477,63 @@ namespace HAOS
 		}
 
 
-		cl_wavwrite_update_wave_header(haOS.outStream.fileHandle);
-
 		// Access the last core in haosSystem.coreTable
 		if (haOS.coresNumber == 0)
 			return;
 
+		outputBricksCnt++;
+
 		pHAOS_Core_t lastCore = &haOS.coreTable[haOS.coresNumber - 1];
 
+		// Silent channels (not in the valid channel mask) aren't cleared in the I/O buffer
+		static const HAOS_BrickBuffer_t silentBrick = { 0 };
+		const HAOS_PcmSample_t* srcPtrs[NUMBER_OF_IO_CHANNELS];
+
+		for (uint32_t channel = 0; channel < haOS.outStream.channelCount; channel++)
+		{
+			srcPtrs[channel] = (lastCore->HAOS_PPM_VALID_CHANNELS & (1U << channel)) ? lastCore->HAOS_IOBUFFER_PTRS[channel] : silentBrick;
+		}
+
+		// Interleave the whole brick of all output channels, then write it at once
+		int32_t samplesToWrite[BRICK_SIZE * NUMBER_OF_IO_CHANNELS];
+		int32_t* dstPtr = samplesToWrite;
+
 		for (int sample = 0; sample < BRICK_SIZE; sample++)
 		{
 			// Write one sample for each valid output channel from the last core
 			for (int channel = 0; channel < haOS.outStream.channelCount; channel++)
 			{
-				int32_t sampleToWrite = lastCore->HAOS_IOBUFFER_PTRS[channel][sample] * SAMPLE_SCALE;
-				//std::cout << "sampleToWrite: 0x" << std::hex << sampleToWrite << std::endl;
-				cl_wavwrite_sendsample(haOS.outStream.fileHandle, sampleToWrite, haOS.outStream.ctrlFlags & HAOS_STREAM_ROUNDING_FLAG);
+				*dstPtr++ = srcPtrs[channel][sample] * SAMPLE_SCALE;
 			}
 		}
+
+		cl_wavwrite_sendsamples(haOS.outStream.fileHandle, samplesToWrite, BRICK_SIZE * haOS.outStream.channelCount,
+			haOS.outStream.ctrlFlags & HAOS_STREAM_ROUNDING_FLAG);
 	}
 	//==============================================================================
 
 	static void flushFrameToFile()
+	{
+		// In offline mode nobody watches the file, the header is written once on close
+		if (haOS.outStream.fileHandle == nullptr || haOS.offline)
+		{
+			return;
+		}
+
+		// The file stays open; only write the data and update the header sizes,
+		// at most once per outUpdateInterval
+		static std::chrono::steady_clock::time_point lastUpdate = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+		if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdate).count() >= haOS.outUpdateInterval)
+		{
+			cl_wavwrite_update_sizes(haOS.outStream.fileHandle);
+			lastUpdate = now;
+		}
+	}
+	//==============================================================================
+
+	static void closeOutputFile()
 	{
 		if (haOS.outStream.fileHandle == nullptr)
 		{
@@ -870,90 +1543,280 @@ namespace HAOS
 		// update file size and number of samples
 		cl_wavwrite_close(haOS.outStream.fileHandle);
 
-		if (getEndOfProcessing()) {
-			std::cout << yellow;
-			std::cout << ">>Output file: " << haOS.outStream.filePath << std::endl;
-			std::cout << ">>Sample rate: " << haOS.outStream.samplingFrequency << std::endl;
-			std::cout << ">>Bits per sample: " << haOS.outStream.bitsPerSample << std::endl;
-			std::cout << ">>Channels: " << haOS.outStream.channelCount << std::endl;
-			std::cout << ">>Samples per channel: " << cl_wavwrite_number_of_channel_samples(haOS.outStream.fileHandle) << std::endl;
-			std::cout << def;
+		std::cout << yellow;
+		std::cout << ">>Output file: " << haOS.outStream.filePath << std::endl;
+		std::cout << ">>Sample rate: " << haOS.outStream.samplingFrequency << std::endl;
+		std::cout << ">>Bits per sample: " << haOS.outStream.bitsPerSample << std::endl;
+		std::cout << ">>Channels: " << haOS.outStream.channelCount << std::endl;
+		std::cout << ">>Samples per channel: " << cl_wavwrite_number_of_channel_samples(haOS.outStream.fileHandle) << std::endl;
+		std::cout << def;
+
+		haOS.outStream.fileHandle = nullptr;
+	}
+	//==============================================================================
+
+	// @brief Prints the offline render summary: audio duration, samples per second and
+	// real-time factor. The time per module and entry point follows in the profile.
+	static void printThroughputReport(double wallSeconds)
+	{
+		double fs = haOS.inStream.samplingFrequency ? haOS.inStream.samplingFrequency : 48000;
+		double chSamples = (double)outputBricksCnt * BRICK_SIZE;
+		uint32_t channels = haOS.coresNumber ? calcChCntBasedOnChMask(haOS.coreTable[haOS.coresNumber - 1].HAOS_PPM_VALID_CHANNELS) : 0;
+
+		if (wallSeconds <= 0)
+		{
+			wallSeconds = 1e-9;
 		}
 
-		if (cl_wavwrite_reopen(const_cast<char*>(haOS.outStream.filePath.c_str()), haOS.outStream.fileHandle))
+		std::cout << yellow;
+		std::cout << ">>Offline render: " << chSamples / fs << " s of audio in " << wallSeconds << " s" << std::endl;
+		std::cout << ">>Throughput: " << (uint64_t)(chSamples / wallSeconds) << " samples/s per channel, "
+			<< (uint64_t)(chSamples * channels / wallSeconds) << " samples/s (" << channels << " channels)" << std::endl;
+		std::cout << ">>Real-time factor: " << chSamples / fs / wallSeconds << "x" << std::endl;
+		std::cout << def;
+	}
+	//==============================================================================
+
+	// @brief Prints the profiler table and writes it as JSON (--profile).
+	//
+	// The load is relative to the duration of the audio written to the output, at the
+	// sample rate of the input stream.
+	static void reportProfile()
+	{
+		uint32_t fs = haOS.inStream.samplingFrequency ? haOS.inStream.samplingFrequency : 48000;
+		double audioSeconds = (double)outputBricksCnt * BRICK_SIZE / fs;
+
+		std::cout << yellow;
+		Profiler::printReport(haOS.coreTable, haOS.coresNumber, audioSeconds, fs);
+		std::cout << def;
+
+		if (!haOS.profilePath.empty())
 		{
-			std::cerr << red << "ERROR: Unable to open output file <flush> '" << haOS.outStream.filePath << "'" << def << std::endl;
-			exit(1);
+			if (Profiler::writeJson(haOS.profilePath, haOS.coreTable, haOS.coresNumber, audioSeconds, fs))
+			{
+				std::cout << yellow << ">>Profile written to " << haOS.profilePath << def << std::endl;
+			}
+			else
+			{
+				std::cerr << "Unable to write profile file '" << haOS.profilePath << "'" << std::endl;
+			}
 		}
+	}
+	//==============================================================================
+
+	static void onSigint(int signal)
+	{
+		stopRequested = 1;
 
+		// A second Ctrl+C terminates immediately
+		std::signal(signal, SIG_DFL);
 	}
 	//==============================================================================
 
-	static void updatePtrs()
+	// Reads all samples of a WAV file (32 bit left justified). Returns the number of channels, -1 on error.
+	static int readWaveSamples(const std::string& filePath, std::vector<int32_t>& samples, int* bitsPerSample)
 	{
-		haOS.readBrickCnt++;
-		if (haOS.readBrickCnt == IO_BUFFER_PER_CHAN_MODULO)
+		WAVREAD_HANDLE* handle;
+
+		if (cl_wavread_open(const_cast<char*>(filePath.c_str()), &handle) != 1)
 		{
-			haOS.readBrickCnt = 0;
+			return -1;
 		}
 
-		// Iterate over all active cores and update their buffer pointers
-		for (auto& core : haOS.coreTable)
+		int channels = cl_wavread_getnchannels(handle);
+		int count = cl_wavread_number_of_channel_samples(handle) * channels;
+		*bitsPerSample = cl_wavread_bits_per_sample(handle);
+
+		samples.resize(count);
+		cl_wavread_recvsamples(handle, (uint32_t*)samples.data(), count, false);
+
+		cl_wavread_close(handle);
+		return channels;
+	}
+	//==============================================================================
+
+	// @brief Compares the output file with the reference WAV file given with --ref.
+	//
+	// Reports the largest sample deviation (in LSBs of the output sample size) and the
+	// SNR of the output against the reference, e.g. to check a float32 build
+	// (HAOS_PCM_FLOAT32) against the output of the double build.
+	static void compareWithReference()
+	{
+		if (haOS.refPath.empty() || haOS.outStream.filePath.empty())
 		{
-			for (int i = 0; i < NUMBER_OF_IO_CHANNELS; ++i)
+			return;
+		}
+
+		std::vector<int32_t> refSamples;
+		std::vector<int32_t> outSamples;
+		int refBits = 0;
+		int outBits = 0;
+		int refChannels = readWaveSamples(haOS.refPath, refSamples, &refBits);
+		int outChannels = readWaveSamples(haOS.outStream.filePath, outSamples, &outBits);
+
+		if (refChannels < 0 || outChannels < 0)
+		{
+			std::cerr << red << "ERROR: Unable to read reference file '" << haOS.refPath << "' or output file" << def << std::endl;
+			return;
+		}
+
+		if (refChannels != outChannels || refBits != outBits || refSamples.size() != outSamples.size())
+		{
+			std::cerr << red << "ERROR: Reference file '" << haOS.refPath << "' doesn't match the output format or length" << def << std::endl;
+			return;
+		}
+
+		double maxDeviation = 0;
+		size_t maxDeviationIdx = 0;
+		double signalEnergy = 0;
+		double noiseEnergy = 0;
+
+		for (size_t i = 0; i < refSamples.size(); i++)
+		{
+			double ref = refSamples[i];
+			double diff = (double)outSamples[i] - ref;
+
+			signalEnergy += ref * ref;
+			noiseEnergy += diff * diff;
+			if (fabs(diff) > maxDeviation)
 			{
-				core.HAOS_IOBUFFER_PTRS[i] = core.IOBUFFER[i][haOS.readBrickCnt];
+				maxDeviation = fabs(diff);
+				maxDeviationIdx = i;
 			}
-			core.IOfree += BRICK_SIZE;
 		}
 
+		// Samples are left justified, one output LSB is 2^(32 - bits)
+		double lsb = ldexp(1.0, 32 - outBits);
 
+		std::cout << yellow;
+		std::cout << ">>Reference file: " << haOS.refPath << std::endl;
+		std::cout << ">>Max deviation: " << maxDeviation / lsb << " LSB (channel " << maxDeviationIdx % outChannels
+			<< ", sample " << maxDeviationIdx / outChannels << ")" << std::endl;
+		if (noiseEnergy == 0)
+		{
+			std::cout << ">>SNR: bit-exact" << std::endl;
+		}
+		else
+		{
+			std::cout << ">>SNR: " << 10 * log10(signalEnergy / noiseEnergy) << " dB" << std::endl;
+		}
+		std::cout << def;
 	}
 	//==============================================================================
 
-	static void readCfgFile(const std::string pathName, HAOS_HostCommQ_t message, uint32_t* msgCnt)
+	static void updatePtrs()
 	{
-		std::ifstream is;
-		is.open(pathName.c_str());
+		HAOS_BrickRing_t* pRing = &haOS.coreTable[0].IOring;
 
-		if (is.is_open())
+		// The brick has been written or handed on, its slot is free for the decoder again
+		BrickRing::commitRead(pRing);
+
+		uint32_t slot = BrickRing::readSlot(pRing);
+
+		// Update the buffer pointers of the cores run by the main loop (with --sequential they
+		// all work on the I/O buffer of core 0), the core threads own theirs
+		for (int coreIdx = 0; coreIdx < mainLoopCoresCnt; coreIdx++)
 		{
-			std::string line;
+			pHAOS_Core_t pCore = &haOS.coreTable[coreIdx];
 
-			while (std::getline(is, line))
+			pCore->HAOS_IOBUFFER_PTRS = pCore->IOBUFFER_BRICK_PTRS[slot];
+			pCore->brickIdx++;
+		}
+	}
+	//==============================================================================
+
+	// Queues the messages collected for a timed section of a cfg file
+	static void flushCfgSection(CfgSection_t* section)
+	{
+		if (!section->messages.empty())
+		{
+			HostCommQueue_t& queue = (section->timing == HOSTCOMM_AT_FRAME) ? frameHostComm : sampleHostComm;
+
+			queue.emplace(section->position, std::move(section->messages));
+			section->messages.clear();
+		}
+	}
+	//==============================================================================
+
+	// Parses one line of a cfg file. The messages of the HOSTCOMM_NOW section go to message,
+	// the ones of timed sections are collected in section.
+	static void parseCfgLine(std::string line, HAOS_HostCommQ_t message, uint32_t* msgCnt, CfgSection_t* section)
+	{
+		if (line.find("#include") == 0)
+		{
+			// process include file
+			std::string includePath = trim(line.substr(8, std::string::npos));
+			readCfgFile(includePath, message, msgCnt, section);
+		}
+		else if (line.find("# Frame: ") == 0 || line.find("# Sample: ") == 0 || line.find("# Now") == 0)
+		{
+			// the following messages are sent when the frame starts, at the first brick
+			// boundary at or after the sample, or at once
+			flushCfgSection(section);
+
+			if (line[2] == 'F')
+			{
+				section->timing = HOSTCOMM_AT_FRAME;
+				section->position = strtoull(line.c_str() + 9, nullptr, 10);
+			}
+			else if (line[2] == 'S')
+			{
+				section->timing = HOSTCOMM_AT_SAMPLE;
+				section->position = strtoull(line.c_str() + 10, nullptr, 10);
+			}
+			else
+			{
+				section->timing = HOSTCOMM_NOW;
+			}
+		}
+		else if (line.find("#") == 0)
+		{
+			// this is a comment, ignore it
+		}
+		else if (!line.empty())
+		{
+			/* assume these are hex digits - parse them into the message queue */
+			if (line.length() > 8 && line.find(' ') == std::string::npos)
 			{
-				if (line.find("#include") == 0)
+				/* Separate two control words*/
+				line = line.substr(0, 8) + " " + line.substr(8);
+			}
+
+			std::istringstream iss(line);
+			uint32_t msg;
+			while (iss >> std::hex >> msg)
+			{
+				if (section->timing != HOSTCOMM_NOW)
 				{
-					// process include file
-					std::string includePath = trim(line.substr(8, std::string::npos));
-					readCfgFile(includePath, message, msgCnt);
+					section->messages.push_back(msg);
 				}
-				else if (line.find("# Frame: ") == 0)
+				else if (*msgCnt < MAX_HOST_COMMANDS_COUNT)
 				{
-					/* Placeholder for code used to simulate dynamic modification of ucmd commands based on the current frame number */
+					message[*msgCnt] = msg;
+					*msgCnt += 1;
 				}
-				else if (line.find("#") == 0)
+				else
 				{
-					// this is a comment, ignore it
+					std::cerr << "Too many host comm messages, '" << line << "' is dropped" << std::endl;
+					break;
 				}
-				else if (!line.empty())
-				{
-					/* assume these are hex digits - parse them into the message queue */
-					if (line.length() > 8 && line.find(' ') == std::string::npos)
-					{
-						/* Separate two control words*/
-						line = line.substr(0, 8) + " " + line.substr(8);
-					}
+			}
+		}
+	}
+	//==============================================================================
 
-					std::istringstream iss(line);
-					uint32_t msg;
-					while (iss >> std::hex >> msg)
-					{
-						message[*msgCnt] = msg;
-						*msgCnt += 1;
-					}
+	static void readCfgFile(const std::string pathName, HAOS_HostCommQ_t message, uint32_t* msgCnt, CfgSection_t* section)
+	{
+		std::ifstream is;
+		is.open(pathName.c_str());
 
-				}
+		if (is.is_open())
+		{
+			std::string line;
+
+			while (std::getline(is, line))
+			{
+				parseCfgLine(line, message, msgCnt, section);
 			}
 			is.close();
 		}
@@ -964,6 +1827,86 @@ namespace HAOS
 	}
 	//==============================================================================
 
+	// Sends the messages of a timed host comm queue up to the given frame or sample position
+	static void applyTimedHostComm(HostCommQueue_t& queue, uint64_t position, const char* unit)
+	{
+		while (!queue.empty() && queue.begin()->first <= position)
+		{
+			HostCommQueue_t::iterator entry = queue.begin();
+
+			processHostComm(entry->second.data(), (uint32_t)entry->second.size());
+
+			// the position the messages take effect at, for measuring the latency to the output
+			if (!haOS.offline)
+			{
+				std::cout << grey << ">>Host comm: " << entry->second.size() << " word(s) for " << unit << " "
+					<< entry->first << " sent at sample " << haOS.coreTable[0].brickIdx * BRICK_SIZE
+					<< " (frame " << haOS.frameCounter << ")" << def << std::endl;
+			}
+
+			queue.erase(entry);
+		}
+	}
+	//==============================================================================
+
+	// Reads the lines the host has appended to the --hostcomm file since the previous call; the
+	// file stands in for the host interface. Messages outside of timed sections are sent at once
+	// (at the next brick), "# Frame: " and "# Sample: " sections are queued as in a cfg file.
+	// A line is only read when it's complete.
+	static void pollHostCommFile()
+	{
+		static std::ifstream is;
+		static CfgSection_t section = { HOSTCOMM_NOW, 0, {} };
+		static bool openFailed = false;
+
+		if (!is.is_open())
+		{
+			is.open(haOS.hostCommPath.c_str());
+			if (!is.is_open())
+			{
+				if (!openFailed)
+				{
+					std::cerr << "Unable to open host comm file '" << haOS.hostCommPath << "', retrying" << std::endl;
+					openFailed = true;
+				}
+				return;
+			}
+		}
+
+		HAOS_HostCommQ_t message;
+		uint32_t msgCnt = 0;
+		std::string line;
+
+		while (true)
+		{
+			std::streampos lineStart = is.tellg();
+
+			if (!std::getline(is, line) || is.eof())
+			{
+				// nothing new or the host is still writing the line, read it again next time
+				is.clear();
+				is.seekg(lineStart);
+				break;
+			}
+
+			parseCfgLine(line, message, &msgCnt, &section);
+		}
+
+		flushCfgSection(&section);
+
+		if (msgCnt > 0)
+		{
+			processHostComm(message, msgCnt);
+
+			if (!haOS.offline)
+			{
+				std::cout << grey << ">>Host comm: " << msgCnt << " word(s) sent at sample "
+					<< haOS.coreTable[0].brickIdx * BRICK_SIZE << " (frame " << haOS.frameCounter << ")" << def << std::endl;
+			}
+		}
+	}
+	//==============================================================================
+
 	static void* getMcvPointer(int32_t moduleID)
 	{
 
@@ -985,7 +1928,10 @@ namespace HAOS
 	}
 	//==============================================================================
 
-	static void processHostComm(HAOS_HostCommQ_t messageQ, uint32_t msgCnt)
+	// Parses host comm messages into MCV writes. The writes are queued for the core of the module
+	// and applied by it before the brick they are for. With applyNow (before the cores run) the
+	// words are written right away and only the notification of the module is queued.
+	static void processHostComm(HAOS_HostCommQ_t messageQ, uint32_t msgCnt, bool applyNow)
 	{
 		//HAOS_HostCommQ_t::const_iterator mb, me;
 
@@ -1013,35 +1959,31 @@ namespace HAOS
 			}
 			default:	// write, OR, or AND
 			{
-				// for each word of the payload, do the right thing
+				HAOS_McvRange_t write;
+
+				write.offset = offset;
+				write.wordCnt = 0;
+				write.brick = 0;
+				write.op = (HAOS_McvOp_t)opCode;
+
+				// collect the payload, one value per word
 				while (msgIdx < msgCnt && numWords > 0)
 				{
-					int32_t value = messageQ[msgIdx++];
+					write.values[write.wordCnt++] = messageQ[msgIdx++];
 					numWords--;
+				}
 
-					if (mcv != 0)
+				// messages are for a resident module only
+				if (mcv != 0 && write.wordCnt > 0)
+				{
+					if (applyNow)
 					{
-						// messages are for a resident module
-						switch (opCode)
-						{
-						case 0:
-						{
-							mcv[offset] = value;
-							break;
-						}
-						case 1:
-						{
-							mcv[offset] |= value;
-							break;
-						}
-						case 2:
-						{
-							mcv[offset] &= value;
-							break;
-						}
-						}
+						applyMcvRange(mcv, &write);
+						write.op = HAOS_MCV_APPLIED;
 					}
-					++offset;
+
+					// the module is notified of the written words before its next foreground call
+					addMcvChange(moduleID, &write);
 				}
 				break;
 			}
@@ -1057,60 +1999,84 @@ namespace HAOS
 
 		if (!haOS.cfgPath.empty())
 		{
-			readCfgFile(haOS.cfgPath, message, &msgCnt);
-			// message is now a list of unsigned int messages
-			processHostComm(message, msgCnt);
+			CfgSection_t section = { HOSTCOMM_NOW, 0, {} };
+
+			readCfgFile(haOS.cfgPath, message, &msgCnt, &section);
+			flushCfgSection(&section);
+
+			// message is now a list of unsigned int messages, the timed ones are queued. The cores
+			// do not run yet, so the untimed writes go to the MCVs right away.
+			processHostComm(message, msgCnt, true);
 		}
 	}
 	//==============================================================================
 
 	void copyBrickToIO(pHAOS_CopyToIOPtrs_t copyToIOPtrs)
 	{
-		if (haOS.pActiveCore == nullptr)
+		if (pActiveCore == nullptr)
 		{
 			return; // No cores present
 		}
 
+		// The channels of the current frame; a new frame may change them
+		HAOS_ChannelMask_t inputChannelMask = copyToIOPtrs->frameData ? copyToIOPtrs->frameData->inputChannelMask : haOS.frameData.inputChannelMask;
+		HAOS_PcmSamplePtr_t* ioBricks = acquireInputBricks();
+
+		// Copy the bricks of the decoded channels to core0 input buffer. The other channels
+		// are silent, they are not cleared.
+		for (HAOS_ChannelMask_t chMask = inputChannelMask; chMask != 0; chMask &= chMask - 1)
+		{
+			int32_t ch = HAOS_lowestChannel(chMask);
+
+			if (copyToIOPtrs->IOBufferPtrs[ch])
+			{
+				memcpy(ioBricks[ch], copyToIOPtrs->IOBufferPtrs[ch], sizeof(HAOS_BrickBuffer_t));
+			}
+			else
+			{
+				memset(ioBricks[ch], 0, sizeof(HAOS_BrickBuffer_t));
+			}
+		}
+
+		commitInputBricks(copyToIOPtrs->frameData);
+	}
+	//==============================================================================
+
+	HAOS_PcmSamplePtr_t* acquireInputBricks()
+	{
+		// Wait for a free brick; the ring can only be full when its consumer runs on another thread
+		BrickRing::waitForFree(&pActiveCore->IOring);
+
+		return pActiveCore->HAOS_IOBUFFER_INP_PTRS;
+	}
+	//==============================================================================
+
+	void commitInputBricks(pHAOS_FrameData_t frameData)
+	{
 		// Copy frame data if present
 		haOS.ctrlFlags &= HAOS_FRAME_TRIGGERED_CLR;
-		if (copyToIOPtrs->frameData != nullptr)
+		if (frameData != nullptr)
 		{
 			haOS.ctrlFlags |= HAOS_FRAME_TRIGGERED_FLAG;
 			haOS.ctrlFlags |= HAOS_DECODING_STARTED_FLAG;
-			memcpy(&haOS.frameData, copyToIOPtrs->frameData, sizeof(HAOS_FrameData_t));
+			memcpy(&haOS.frameData, frameData, sizeof(HAOS_FrameData_t));
 
 			/* Update output file controls */
 			haOS.outStream.samplingFrequency = haOS.frameData.sampleRate;
 
-		}
-
-		// Copy bricks to core0 input buffer
-		for (int ch = 0; ch < NUMBER_OF_IO_CHANNELS; ch++)
-		{
-			if (copyToIOPtrs->IOBufferPtrs[ch])
-			{
-				memcpy(haOS.pActiveCore->HAOS_IOBUFFER_INP_PTRS[ch], copyToIOPtrs->IOBufferPtrs[ch], sizeof(HAOS_BrickBuffer_t));
-			}
-			else
+			/* A bitstream has no channel count in its header, it is known once the decoder delivers the frame */
+			if ((haOS.inStream.type != DECODE_INFO_PCM) && (haOS.inStream.channelCount == 0))
 			{
-				memset(haOS.pActiveCore->HAOS_IOBUFFER_INP_PTRS[ch], 0, sizeof(HAOS_BrickBuffer_t));
+				haOS.inStream.channelCount = calcChCntBasedOnChMask(frameData->outputChannelMask);
 			}
+
 		}
 
-		// Update I/O buffer space accounting
-		haOS.pActiveCore->IOfree -= BRICK_SIZE;
+		// Hand the brick to the consumer
+		BrickRing::commitWrite(&pActiveCore->IOring);
 
 		// Update input pointers for core0
-		haOS.writeBrickCnt++;
-		if (haOS.writeBrickCnt == IO_BUFFER_PER_CHAN_MODULO)
-		{
-			haOS.writeBrickCnt = 0;
-		}
-
-		for (int i = 0; i < NUMBER_OF_IO_CHANNELS; ++i)
-		{
-			haOS.pActiveCore->HAOS_IOBUFFER_INP_PTRS[i] = haOS.pActiveCore->IOBUFFER[i][haOS.writeBrickCnt];
-		}
+		pActiveCore->HAOS_IOBUFFER_INP_PTRS = pActiveCore->IOBUFFER_BRICK_PTRS[BrickRing::writeSlot(&pActiveCore->IOring)];
 	}
 	//==============================================================================
 
@@ -1164,10 +2130,7 @@ namespace HAOS
 				uint32_t* dstPtr = BitRipper::getWritePtr();
 
 				/* Read samples from file into FIFO */
-				for (int sample = 0; sample < freeSamplesCnt; sample++)
-				{
-					*dstPtr++ = cl_wavread_recvsample(haOS.inStream.fileHandle, haOS.inStream.ctrlFlags & HAOS_STREAM_COMMPRESSED_FLAG);
-				}
+				cl_wavread_recvsamples(haOS.inStream.fileHandle, dstPtr, freeSamplesCnt, haOS.inStream.ctrlFlags & HAOS_STREAM_COMMPRESSED_FLAG);
 
 
 				/* Advance FIFO write pointer */
@@ -1231,8 +2194,14 @@ namespace HAOS
 		std::cout << grey;
 		std::cout << "usage: " << programName << " [options]" << std::endl
 			<< "  where options are:" << std::endl
-			<< "    --fg2bg <ratio of brick to background entry point calls> - default is 16" << std::endl
+			<< "    --fg2bg <ratio of brick to background entry point calls> - default is one frame: "
+			<< HAOS_PCM_FRAME_SIZE / BRICK_SIZE << " (PCM), " << HAOS_MP3_FRAME_SIZE / BRICK_SIZE << " (MP3)" << std::endl
 			<< "    --cfg <cfg file pathname> : pathname of host comm messages to send prekick" << std::endl
+			<< "           Messages after a '# Frame: <n>' line are sent when frame n starts, after a" << std::endl
+			<< "           '# Sample: <n>' line at the first brick boundary at or after sample n" << std::endl
+			<< "           ('# Now' ends a timed section)" << std::endl
+			<< "    --hostcomm <file pathname> : file the host appends messages to during the run (cfg file" << std::endl
+			<< "           format), read after every frame; untimed messages are sent at the next brick" << std::endl
 			<< "    --input <input audio WAV file pathname> : pathname of audio file to use as input" << std::endl
 			<< "           WAV file channels are mapped to IOBUFFER channels based on the CS498XX PCM decoder MCV" << std::endl
 			<< "           settings for index 0x0001 through 0x0010. Those default to mapping each WAV channel" << std::endl
@@ -1243,7 +2212,22 @@ namespace HAOS
 			<< "           is written to WAV channel 1, etc." << std::endl
 			<< "    --osamplesize <output sample size in bits> - default is 16" << std::endl
 			<< "    --ofs <output sample rate> - default is 48000" << std::endl
+			<< "    --oupdate <ms> - wall-clock interval for updating the output file header during the run," << std::endl
+			<< "           default is 1000, 0 updates it every frame" << std::endl
 			<< "    --app [0, 1] - whether to use the mp3 decoder or pcm decoder. Default is 0 (pcm)." << std::endl
+			<< "    --iobricks <n> - number of bricks per channel in the I/O buffer ring, a power of 2 up to "
+			<< IO_BUFFER_BRICKS_MAX << "," << std::endl
+			<< "           default is " << IO_BUFFER_BRICKS_DFLT << std::endl
+			<< "    --offline - batch rendering: no output header updates and no debug logs during the run," << std::endl
+			<< "           large output buffer, throughput summary (samples/s, real-time factor, time per" << std::endl
+			<< "           module and entry point) at the end" << std::endl
+			<< "    --sequential - run all cores one after the other on one thread. By default cores 1 .. N run on" << std::endl
+			<< "           their own threads and process the bricks of core 0 as a pipeline" << std::endl
+			<< "    --profile <JSON file pathname> : measure every module entry point call; min, mean, p99, max" << std::endl
+			<< "           and load (MCPS, % of a host core at the stream sample rate) are printed at shutdown" << std::endl
+			<< "           and written to this file" << std::endl
+			<< "    --ref <reference WAV file pathname> : after the run, report the max deviation and SNR of the output" << std::endl
+			<< "           against this file (e.g. float32 build against the double build)" << std::endl
 			;
 		std::cout << yellow << ">>Exiting haOS" << std::endl;
 		std::cout << def;
@@ -2,29 +2,51 @@
 #include <iostream>
 
 extern HAOS_Odt_t PcmDecoder_odt;
-extern HAOS_Odt_t Mp3Decoder_odt;
+extern HAOS_Odt_t mp3Decoder_odt;
 extern HAOS_Odt_t AudioManager_odt;
 extern HAOS_Mif_t fxMIF;
 
+// Build with -DODT_MP3_DECODER=1 to decode MP3 input (run with --app 1) instead of PCM
+#ifndef ODT_MP3_DECODER
+#define ODT_MP3_DECODER 0
+#endif
+
+// Build with -DODT_SPLIT_CORES=1 to run FX on core 1 and AudioManager on core 2,
+// each on its own thread (see --sequential)
+#ifndef ODT_SPLIT_CORES
+#define ODT_SPLIT_CORES 0
+#endif
+
 namespace ODT
 {
 	HAOS_OdtEntry_t coreODT[MAX_NUMBER_OF_CORES][MAX_NUMBER_OF_MODULES_PER_CORE] =
 	{
 		// Core 0 ODT
 		{
-			{PcmDecoder_odt->MIF, PcmDecoder_odt->moduleID},
-			//{Mp3Decoder_odt->MIF, Mp3Decoder_odt->moduleID},
-			{&fxMIF, 0x50},
-			{AudioManager_odt->MIF, AudioManager_odt->moduleID},
-			{0, 0} // null entry terminates the table of modules
+#if ODT_MP3_DECODER
+			{mp3Decoder_odt->MIF, mp3Decoder_odt->moduleID, mp3Decoder_odt->name},
+#else
+			{PcmDecoder_odt->MIF, PcmDecoder_odt->moduleID, PcmDecoder_odt->name},
+#endif
+#if !ODT_SPLIT_CORES
+			{&fxMIF, 0x50, "FX"},
+			{AudioManager_odt->MIF, AudioManager_odt->moduleID, AudioManager_odt->name},
+#endif
+			{0, 0, 0} // null entry terminates the table of modules
 		},
 		// Core 1 ODT
 		{
-			{0, 0} // null entry terminates the table of modules
+#if ODT_SPLIT_CORES
+			{&fxMIF, 0x50, "FX"},
+#endif
+			{0, 0, 0} // null entry terminates the table of modules
 		},
 		// Core 2 ODT
 		{
-			{0, 0} // null entry terminates the table of modules
+#if ODT_SPLIT_CORES
+			{AudioManager_odt->MIF, AudioManager_odt->moduleID, AudioManager_odt->name},
+#endif
+			{0, 0, 0} // null entry terminates the table of modules
 		}
 	};
 
@@ -32,11 +54,12 @@ namespace ODT
 
 	void** getMasterTable()
 	{
-		int32_t coreIdx = 0;
-		pHAOS_OdtEntry_t pCoreODT = coreODT[coreIdx];
-		masterODT[0] = pCoreODT;
-		masterODT[1] = NULL;
-		masterODT[2] = NULL;
+		// Core 0 is always used; the other cores only when modules are assigned to them
+		masterODT[0] = coreODT[0];
+		for (int32_t coreIdx = 1; coreIdx < MAX_NUMBER_OF_CORES; coreIdx++)
+		{
+			masterODT[coreIdx] = coreODT[coreIdx][0].MIF ? coreODT[coreIdx] : NULL;
+		}
 
 		return masterODT;
 	}
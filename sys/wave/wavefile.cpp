@@ -12,6 +12,17 @@
 #include <errno.h>
 #include <assert.h>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "wavefile.h"
 
  //================================ local helper types ================================
@@ -40,6 +51,13 @@ struct DATAHDR
     unsigned int    dataSize;
 };
 
+// Header of any RIFF chunk (id + size, followed by size bytes and a pad byte if size is odd)
+struct CHUNKHDR
+{
+    char            chunkID[4];
+    unsigned int    chunkSize;
+};
+
 struct COMBINEDHDR
 {
     RIFFHDR     riffHdr;
@@ -48,6 +66,13 @@ struct COMBINEDHDR
 };
 
 #define     WAVE_FORMAT_PCM         1
+#define     WAVE_FORMAT_EXTENSIBLE  0xFFFE
+
+// Size of the output staging buffer; samples are packed here and written with one fwrite
+#define     WAVWRITE_BUFFER_SIZE    (64 * 1024)
+
+// Largest staging buffer that can be set with cl_wavwrite_set_buffer_size()
+#define     WAVWRITE_BUFFER_SIZE_MAX    (1024 * 1024)
 
 
 
@@ -63,60 +88,74 @@ typedef struct
     FORMATHDR       formatHdr;
     int             nChannelSamples;
 
+    unsigned char*  writeBuffer;        // staging buffer of packed samples (output only)
+    int             writeBufferPos;     // number of bytes in the staging buffer
+    int             writeBufferSize;    // usable size of the staging buffer, in bytes
+
+    const unsigned char* mapBase;       // input file mapped into memory (input only)
+    size_t          mapSize;
+    bool            mapOnHeap;          // mapping failed, the file was read into heap memory
+    const unsigned char* data;          // data chunk (the whole file for a non-WAV input)
+    size_t          dataSize;
+    size_t          readPos;            // read position in the data chunk, in bytes
+    bool            eof;                // a read went past the end of the data chunk
 
 }wavefile_info_t, * pWavefile_info_t;
 
-static wavefile_info_t inputWaveFileInfo = { 0 };
-static wavefile_info_t outputWaveFileInfo = { 0 };
+static wavefile_info_t inputWaveFileInfo;
+static wavefile_info_t outputWaveFileInfo;
+static unsigned char outputWriteBuffer[WAVWRITE_BUFFER_SIZE_MAX];
 
 
-static int read_wave_hdr(FILE* handle, FORMATHDR* waveFormat, RIFFHDR* riffHdr, DATAHDR* dataHdr);
+static int map_file(const char* fileName, pWavefile_info_t info);
+static void unmap_file(pWavefile_info_t info);
+static int parse_wave_hdr(const unsigned char* base, size_t size, FORMATHDR* waveFormat, size_t* dataOffset, size_t* dataSize);
 static void mod_wave_header(const pWavefile_info_t info);
+static void flush_write_buffer(const pWavefile_info_t info);
 
 //============================ published functions from dsplib/wavefile.h ===============
 
 int cl_wavread_open(char* filename, WAVREAD_HANDLE** info)
 {
     int retValue = 1;
-    std::string fileName = filename;
     *info = static_cast<WAVREAD_HANDLE*>(&inputWaveFileInfo);
 
-    FILE* fileHandle = fopen(fileName.c_str(), "rb");
-
-    if (fileHandle == NULL)
+    if (map_file(filename, &inputWaveFileInfo))
     {
         return -1;
     }
-    inputWaveFileInfo.fileHandle = fileHandle;
 
+    inputWaveFileInfo.fileHandle = NULL;
+    inputWaveFileInfo.readPos = 0;
+    inputWaveFileInfo.eof = false;
 
-    // try to readwave header
+    // try to parse wave header
     FORMATHDR formatHdr;
-    RIFFHDR riffHdr;
-    DATAHDR dataHdr;
+    size_t dataOffset;
+    size_t dataSize;
 
-    if (!read_wave_hdr(fileHandle, &formatHdr, &riffHdr, &dataHdr))
+    if (!parse_wave_hdr(inputWaveFileInfo.mapBase, inputWaveFileInfo.mapSize, &formatHdr, &dataOffset, &dataSize))
     {
         int bytesPerFrame = formatHdr.nChannels * (formatHdr.wBitsPerSample / 8);
 
         inputWaveFileInfo.nChannels = formatHdr.nChannels;
         inputWaveFileInfo.bitsPerSample = formatHdr.wBitsPerSample;
         inputWaveFileInfo.nCurrentSample = 0;
-        inputWaveFileInfo.nChannelSamples = dataHdr.dataSize / bytesPerFrame;
+        inputWaveFileInfo.nChannelSamples = dataSize / bytesPerFrame;
         inputWaveFileInfo.formatHdr = formatHdr;
         inputWaveFileInfo.nSamplesPerSecond = formatHdr.nSamplesPerSec;
+        inputWaveFileInfo.data = inputWaveFileInfo.mapBase + dataOffset;
+        inputWaveFileInfo.dataSize = dataSize;
     }
     else
     {
-        // Not a PCM wave file
+        // Not a PCM wave file, the whole file is the bitstream
         inputWaveFileInfo.bitsPerSample = 32;
         inputWaveFileInfo.nCurrentSample = 0;
         inputWaveFileInfo.nChannelSamples = -1;
         inputWaveFileInfo.nSamplesPerSecond = 0;
-
-        // move fileReadPtr to the beginning of file
-        fclose(fileHandle);
-        fileHandle = fopen(fileName.c_str(), "rb");
+        inputWaveFileInfo.data = inputWaveFileInfo.mapBase;
+        inputWaveFileInfo.dataSize = inputWaveFileInfo.mapSize;
 
         // input file is not WAVE
         retValue = 0;
@@ -130,9 +169,8 @@ int cl_wavread_close(WAVREAD_HANDLE* handle)
     if (handle != NULL)
     {
         wavefile_info_t* info = static_cast<wavefile_info_t*>(handle);
-        int result = fclose(inputWaveFileInfo.fileHandle);
-        handle = NULL;
-        return result;
+        unmap_file(info);
+        return 0;
     }
     else
     {
@@ -199,78 +237,124 @@ int cl_wavread_eof(WAVREAD_HANDLE* handle)
 {
     if (handle != NULL) {
         wavefile_info_t* info = static_cast<wavefile_info_t*>(handle);
-        return feof(info->fileHandle);
+        return info->eof;
     }
     else {
         return 1;
     }
 }
 
+// Converts one PCM sample (little endian, 1 to 4 bytes) to 32 bit left justified
+static inline uint32_t pcm_word(const unsigned char* src, int bytesPerSample)
+{
+    uint32_t word = 0;
+    for (int i = 0; i < bytesPerSample; i++)
+    {
+        word = (word >> 8) | ((uint32_t)src[i] << 24);
+    }
+    return word;
+}
+
+// Converts one 32 bit bitstream word; DTS 16 bit WAVE input has swapped byte order
+static inline uint32_t bitstream_word(const unsigned char* src, int bytesPerSample)
+{
+    if (bytesPerSample == 2)
+    {
+        return ((uint32_t)src[1] << 24) | ((uint32_t)src[0] << 16) | ((uint32_t)src[3] << 8) | src[2];
+    }
+    return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+}
+
 int cl_wavread_recvsample(WAVREAD_HANDLE* handle, bool compressedStream)
+{
+    uint32_t sample = 0;
+    cl_wavread_recvsamples(handle, &sample, 1, compressedStream);
+    return (int)sample;
+}
+
+int cl_wavread_recvsamples(WAVREAD_HANDLE* handle, uint32_t* samples, int count, bool compressedStream)
 {
     if (handle == NULL) {
+        memset(samples, 0, count * sizeof(uint32_t));
         return 0;
     }
-    else {
-        wavefile_info_t* info = static_cast<wavefile_info_t*>(handle);
-        unsigned char           ucData[4] = { 0,0,0,0 };
-        int                     nItemsRead;
-        int                     bytesPerSample;
-        int                     retValue;
 
-        FILE* fp = info->fileHandle;
+    wavefile_info_t* info = static_cast<wavefile_info_t*>(handle);
+    int bytesPerSample = info->bitsPerSample >> 3;
+    int bytesPerWord = compressedStream ? 4 : bytesPerSample;
+
+    assert((!compressedStream || bytesPerSample != 3) && "Invalid size of input bitstream sample (24 bits)!");
 
-        bytesPerSample = info->bitsPerSample >> 3;
+    const unsigned char* src = info->data + info->readPos;
+    size_t bytesLeft = info->dataSize - info->readPos;
 
-        if (!compressedStream)
+    /* Whole words available in the data chunk */
+    int wordsRead = count;
+    if ((size_t)count * bytesPerWord > bytesLeft)
+    {
+        wordsRead = (int)(bytesLeft / bytesPerWord);
+        info->eof = true;
+    }
+
+    if (!compressedStream)
+    {
+        /* input file - PCM wave */
+        switch (bytesPerSample)
         {
-            /* input file - PCM wave */
-            nItemsRead = fread(ucData, sizeof(uint8_t), bytesPerSample, fp);
-            if (nItemsRead < 1)
+        case 2:
+            for (int i = 0; i < wordsRead; i++, src += 2)
             {
-                return 0;
+                samples[i] = ((uint32_t)src[1] << 24) | ((uint32_t)src[0] << 16);
             }
-            info->nCurrentSample++;
-
-            retValue = ucData[0] << 24;
-            for (int i = 1; i < bytesPerSample; i++)
+            break;
+        case 3:
+            for (int i = 0; i < wordsRead; i++, src += 3)
             {
-                retValue >>= 8;
-                retValue &= 0x00ffffff;
-                retValue |= ucData[i] << 24;
+                samples[i] = ((uint32_t)src[2] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[0] << 8);
             }
-        }
-        else
-        {
-            /* input file - compressed bitstream */
-
-            assert((bytesPerSample != 3) && "Invalid size of input bitstream sample (24 bits)!");
-
-            /* Read 32 bits from input file */
-            nItemsRead = fread(ucData, sizeof(uint8_t), 4, fp);
-            if (nItemsRead < 1)
+            break;
+        default:
+            for (int i = 0; i < wordsRead; i++, src += bytesPerSample)
             {
-                return 0;
+                samples[i] = pcm_word(src, bytesPerSample);
             }
+            break;
+        }
+    }
+    else
+    {
+        /* input file - compressed bitstream, 32 bits per word */
+        for (int i = 0; i < wordsRead; i++, src += 4)
+        {
+            samples[i] = bitstream_word(src, bytesPerSample);
+        }
+    }
 
-            retValue = (ucData[0] << 24) | (ucData[1] << 16) | (ucData[2] << 8) | ucData[3];
+    size_t bytesRead = (size_t)wordsRead * bytesPerWord;
 
-            /* Adjust samples count */
-            if (bytesPerSample == 4) info->nCurrentSample++;
-            if (bytesPerSample == 1) info->nCurrentSample += 4;
+    /* A partial word at the end of the data is zero padded */
+    if (wordsRead < count && bytesRead < bytesLeft)
+    {
+        unsigned char lastWord[4] = { 0, 0, 0, 0 };
+        memcpy(lastWord, src, bytesLeft - bytesRead);
+        samples[wordsRead++] = compressedStream ? bitstream_word(lastWord, bytesPerSample) : pcm_word(lastWord, bytesPerSample);
+        bytesRead = bytesLeft;
+    }
 
-            /* Do the correct byte order for DTS 16bits WAVE input samples */
-            if (bytesPerSample == 2)
-            {
-                info->nCurrentSample += 2;
-                retValue = (ucData[1] << 24) | (ucData[0] << 16) | (ucData[3] << 8) | ucData[2];
-            }
+    /* Samples past the end of the data are silence */
+    for (int i = wordsRead; i < count; i++)
+    {
+        samples[i] = 0;
+    }
 
-        }
+    info->readPos += bytesRead;
 
+    /* Adjust samples count */
+    if (!compressedStream || bytesPerSample == 4) info->nCurrentSample += wordsRead;
+    else if (bytesPerSample == 1) info->nCurrentSample += 4 * wordsRead;
+    else if (bytesPerSample == 2) info->nCurrentSample += 2 * wordsRead;
 
-        return retValue;
-    }
+    return wordsRead;
 }
 
 int cl_wavwrite_open(char* filename, int wBitsPerSample, int nChannels, int nFrameRate, WAVREAD_HANDLE** info)
@@ -324,6 +408,9 @@ int cl_wavwrite_open(char* filename, int wBitsPerSample, int nChannels, int nFra
     outputWaveFileInfo.nCurrentSample = 0;
     outputWaveFileInfo.nChannelSamples = 0;
     outputWaveFileInfo.nSamplesPerSecond = hdr.formatHdr.nSamplesPerSec;
+    outputWaveFileInfo.writeBuffer = outputWriteBuffer;
+    outputWaveFileInfo.writeBufferPos = 0;
+    outputWaveFileInfo.writeBufferSize = WAVWRITE_BUFFER_SIZE;
 
     return 0;
 }
@@ -352,6 +439,7 @@ void cl_wavwrite_close(WAVWRITE_HANDLE* handle)
     {
         pWavefile_info_t info = static_cast<pWavefile_info_t>(handle);
 
+        flush_write_buffer(info);
         mod_wave_header(info);
         //
         // Perform the actual fclose on the pc.
@@ -363,17 +451,112 @@ void cl_wavwrite_close(WAVWRITE_HANDLE* handle)
 }
 
 void cl_wavwrite_sendsample(WAVWRITE_HANDLE* handle, int sample, bool rounidng)
+{
+    cl_wavwrite_sendsamples(handle, &sample, 1, rounidng);
+}
+
+void cl_wavwrite_sendsamples(WAVWRITE_HANDLE* handle, const int* samples, int count, bool rounding)
 {
     if (handle != NULL)
     {
         pWavefile_info_t info = static_cast<pWavefile_info_t>(handle);
-        FILE* fileHandle = info->fileHandle;
-        sample = sample >> (32 - info->bitsPerSample);
-        fwrite(&sample, info->bitsPerSample >> 3, 1, fileHandle);
-        info->nCurrentSample++;
+        int bytesPerSample = info->bitsPerSample >> 3;
+        int shift = 32 - info->bitsPerSample;
+
+        while (count > 0)
+        {
+            if (info->writeBufferPos + bytesPerSample > info->writeBufferSize)
+            {
+                flush_write_buffer(info);
+            }
+
+            // Pack as many samples as fit in the staging buffer (little endian)
+            int n = (info->writeBufferSize - info->writeBufferPos) / bytesPerSample;
+            if (n > count) n = count;
+
+            unsigned char* dst = info->writeBuffer + info->writeBufferPos;
+            switch (bytesPerSample)
+            {
+            case 2:
+                for (int i = 0; i < n; i++)
+                {
+                    int sample = samples[i] >> shift;
+                    dst[0] = (unsigned char)sample;
+                    dst[1] = (unsigned char)(sample >> 8);
+                    dst += 2;
+                }
+                break;
+            case 3:
+                for (int i = 0; i < n; i++)
+                {
+                    int sample = samples[i] >> shift;
+                    dst[0] = (unsigned char)sample;
+                    dst[1] = (unsigned char)(sample >> 8);
+                    dst[2] = (unsigned char)(sample >> 16);
+                    dst += 3;
+                }
+                break;
+            default:
+                for (int i = 0; i < n; i++)
+                {
+                    int sample = samples[i] >> shift;
+                    for (int b = 0; b < bytesPerSample; b++)
+                    {
+                        *dst++ = (unsigned char)(sample >> (8 * b));
+                    }
+                }
+                break;
+            }
+
+            info->writeBufferPos += n * bytesPerSample;
+            info->nCurrentSample += n;
+            samples += n;
+            count -= n;
+        }
+    }
+}
+
+void cl_wavwrite_update_sizes(WAVWRITE_HANDLE* handle)
+{
+    if (handle != NULL)
+    {
+        pWavefile_info_t info = static_cast<pWavefile_info_t>(handle);
+
+        flush_write_buffer(info);
+        mod_wave_header(info);
+
+        // return to the end of the file and hand the data to the OS
+        fseek(info->fileHandle, 0, SEEK_END);
+        fflush(info->fileHandle);
     }
 }
 
+void cl_wavwrite_flush(WAVWRITE_HANDLE* handle)
+{
+    if (handle != NULL)
+    {
+        flush_write_buffer(static_cast<pWavefile_info_t>(handle));
+    }
+}
+
+int cl_wavwrite_set_buffer_size(WAVWRITE_HANDLE* handle, int size)
+{
+    if (handle == NULL)
+    {
+        return -1;
+    }
+    pWavefile_info_t info = static_cast<pWavefile_info_t>(handle);
+
+    if (size > WAVWRITE_BUFFER_SIZE_MAX) size = WAVWRITE_BUFFER_SIZE_MAX;
+    if (size < 4) size = 4;
+
+    // the staged samples must fit in the new size
+    flush_write_buffer(info);
+    info->writeBufferSize = size;
+
+    return size;
+}
+
 int cl_wavwrite_sample_number(WAVWRITE_HANDLE* handle)
 {
     if (handle != NULL) {
@@ -426,97 +609,193 @@ void cl_wavwrite_update_wave_header(WAVWRITE_HANDLE* handle)
 }
 
 //====================== local helper functions ==============================
-int read_wave_hdr(FILE* handle, FORMATHDR* waveFormat, RIFFHDR* riffHdr, DATAHDR* dataHdr)
+// Writes the staged samples to the file with a single fwrite
+static void flush_write_buffer(const pWavefile_info_t info)
 {
-    int i;
-    short fmtExtraSize;
-    if (fread(riffHdr, sizeof(RIFFHDR), 1, handle) == 0)
+    if (info->writeBufferPos > 0)
     {
-        return -1;
+        fwrite(info->writeBuffer, 1, info->writeBufferPos, info->fileHandle);
+        info->writeBufferPos = 0;
     }
+}
+
+// Maps the whole file into memory (read only). Falls back to reading it into heap memory.
+static int map_file(const char* fileName, pWavefile_info_t info)
+{
+    info->mapBase = NULL;
+    info->mapSize = 0;
+    info->mapOnHeap = false;
 
-    if (memcmp(riffHdr->chunkID, "RIFF", 4) &&  // "RIFF"
-        memcmp(riffHdr->riffType, "WAVE", 4))
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
     {
         return -1;
     }
 
-    /*
-        if(fread(waveFormat, sizeof(FORMATHDR), 1, handle) == 0)
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    info->mapSize = (size_t)size.QuadPart;
+
+    if (info->mapSize > 0)
+    {
+        // The view keeps the mapping alive, both handles can be closed right away
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping != NULL)
         {
-            return -1;
+            info->mapBase = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
         }
-    */
-
-    /* Check 'fmt ' chunk tag and size */
-    if (fread(waveFormat, 8, 1, handle) == 0)
+    }
+    CloseHandle(file);
+#else
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
     {
         return -1;
     }
 
-    /* Check if 'JUNK' chunk inserted */
-    if (!memcmp(waveFormat->fmtID, "JUNK", 4))
+    struct stat st;
+    fstat(fd, &st);
+    info->mapSize = (size_t)st.st_size;
+
+    if (info->mapSize > 0)
+    {
+        void* base = mmap(NULL, info->mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base != MAP_FAILED)
+        {
+            madvise(base, info->mapSize, MADV_SEQUENTIAL);
+            info->mapBase = (const unsigned char*)base;
+        }
+    }
+    close(fd);
+#endif
+
+    if (info->mapBase == NULL && info->mapSize > 0)
     {
-        /* Skip and discard JUNK chunk data encountered in the input file */
-        for (i = 0; i < waveFormat->fmtSize; i++)
+        FILE* fileHandle = fopen(fileName, "rb");
+        if (fileHandle == NULL)
         {
-            fgetc(handle);
+            return -1;
         }
 
-        /* Read 'fmt ' chunk tag & size */
-        if (fread(waveFormat, 8, 1, handle) == 0)
+        unsigned char* buffer = (unsigned char*)malloc(info->mapSize);
+        if (buffer == NULL || fread(buffer, 1, info->mapSize, fileHandle) != info->mapSize)
         {
+            free(buffer);
+            fclose(fileHandle);
             return -1;
         }
+        fclose(fileHandle);
+
+        info->mapBase = buffer;
+        info->mapOnHeap = true;
     }
 
-    /* Read the rest of thr 'fmt ' chunk */
-    if (fread(&waveFormat->wFormatTag, sizeof(FORMATHDR) - 8, 1, handle) == 0)
+    return 0;
+}
+
+static void unmap_file(pWavefile_info_t info)
+{
+    if (info->mapBase != NULL)
     {
-        return -1;
+        if (info->mapOnHeap)
+        {
+            free((void*)info->mapBase);
+        }
+        else
+        {
+#if defined(_WIN32)
+            UnmapViewOfFile(info->mapBase);
+#else
+            munmap((void*)info->mapBase, info->mapSize);
+#endif
+        }
     }
 
+    info->mapBase = NULL;
+    info->mapSize = 0;
+    info->data = NULL;
+    info->dataSize = 0;
+    info->readPos = 0;
+}
 
-    if (memcmp(waveFormat->fmtID, "fmt ", 4) &&
-        !(waveFormat->fmtSize == 16 || waveFormat->fmtSize == 18) &&
-        waveFormat->wFormatTag != WAVE_FORMAT_PCM)
-    {
+// Walks the RIFF chunks in any order (LIST, fact, JUNK, ... are skipped) to find 'fmt ' and 'data'
+static int parse_wave_hdr(const unsigned char* base, size_t size, FORMATHDR* waveFormat, size_t* dataOffset, size_t* dataSize)
+{
+    RIFFHDR riffHdr;
+    bool fmtFound = false;
 
+    if (size < sizeof(RIFFHDR))
+    {
         return -1;
-
     }
 
-    if (waveFormat->wBitsPerSample != 8 &&
-        waveFormat->wBitsPerSample != 16 &&
-        waveFormat->wBitsPerSample == 24 &&
-        waveFormat->wBitsPerSample == 32)
+    memcpy(&riffHdr, base, sizeof(RIFFHDR));
+    if (memcmp(riffHdr.chunkID, "RIFF", 4) || memcmp(riffHdr.riffType, "WAVE", 4))
     {
         return -1;
     }
 
-    //
-    // If the format is 18, read the extra information.
-    //
-    if (waveFormat->fmtSize == 18 || waveFormat->fmtSize == 40)
+    size_t pos = sizeof(RIFFHDR);
+    while (pos + sizeof(CHUNKHDR) <= size)
     {
-        fread(&fmtExtraSize, 1, sizeof(unsigned short), handle);
-        for (i = 0; i < fmtExtraSize; i++)
+        CHUNKHDR chunk;
+        memcpy(&chunk, base + pos, sizeof(CHUNKHDR));
+        pos += sizeof(CHUNKHDR);
+
+        size_t chunkSize = chunk.chunkSize;
+
+        if (!memcmp(chunk.chunkID, "fmt ", 4))
         {
-            fgetc(handle);
+            if (chunkSize < 16 || pos + 16 > size)
+            {
+                return -1;
+            }
+
+            memcpy(waveFormat->fmtID, chunk.chunkID, 4);
+            waveFormat->fmtSize = chunk.chunkSize;
+            memcpy(&waveFormat->wFormatTag, base + pos, 16);
+
+            if (waveFormat->wFormatTag != WAVE_FORMAT_PCM && waveFormat->wFormatTag != WAVE_FORMAT_EXTENSIBLE)
+            {
+                return -1;
+            }
+
+            if (waveFormat->nChannels == 0 ||
+                (waveFormat->wBitsPerSample != 8 &&
+                 waveFormat->wBitsPerSample != 16 &&
+                 waveFormat->wBitsPerSample != 24 &&
+                 waveFormat->wBitsPerSample != 32))
+            {
+                return -1;
+            }
+
+            fmtFound = true;
         }
+        else if (!memcmp(chunk.chunkID, "data", 4))
+        {
+            if (!fmtFound)
+            {
+                return -1;
+            }
 
-    }
+            // A file that was not closed properly may have a too large data size
+            if (chunkSize > size - pos)
+            {
+                chunkSize = size - pos;
+            }
 
-    if (fread(dataHdr, sizeof(DATAHDR), 1, handle) == 0)
-    {
-        return -1;
-    }
-    if (memcmp(dataHdr->dataID, "data", 4) != 0)
-    {
-        return -1;
+            *dataOffset = pos;
+            *dataSize = chunkSize;
+            return 0;
+        }
+
+        // chunks are word aligned
+        pos += chunkSize + (chunkSize & 1);
     }
 
-    return 0;
+    return -1;
 }
 
 // ****************************************************************************
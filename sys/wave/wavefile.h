@@ -12,6 +12,8 @@
 #ifndef _H_WAVFILE
 #define _H_WAVFILE
 
+#include <stdint.h>
+
 typedef void WAVREAD_HANDLE;
 typedef void WAVWRITE_HANDLE;
 
@@ -279,6 +281,36 @@ int cl_wavread_eof(WAVREAD_HANDLE* handle);
  */
 int cl_wavread_recvsample(WAVREAD_HANDLE* handle, bool compressedStream);
 
+/**
+ * @brief Reads the next count samples from the wave file.
+ *
+ * The input file is memory mapped, so the samples are converted in one pass straight
+ * from the data chunk. Same format as cl_wavread_recvsample: 32 bit signed left
+ * justified for PCM wave, 32 bit words for a compressed stream.
+ * Samples past the end of the data are returned as 0 and set the end of file flag.
+ *
+ * NOTE:  Only available in the single core simulator.
+ *
+ * @param[in]   handle
+ *              Waveread stream handle.
+ *
+ * @param[out]  samples
+ *              Array of count samples.
+ *
+ * @param[in]   count
+ *              Number of samples to read.
+ *
+ * @param[in]   compressedStream
+ *              Same as for cl_wavread_recvsample.
+ *
+ * @return      Number of samples read from the file.
+ *
+ * C Include file: <dsp_lib/wavefile.h>
+ *
+ * @ingroup simulator
+ */
+int cl_wavread_recvsamples(WAVREAD_HANDLE* handle, uint32_t* samples, int count, bool compressedStream);
+
 /**
  * @brief Creates/opens a wave file for writing and creates the proper wave header.
  *
@@ -392,6 +424,92 @@ void cl_wavwrite_close(WAVWRITE_HANDLE* handle);
  */
 void cl_wavwrite_sendsample(WAVWRITE_HANDLE* handle, int sample, bool rounidng);
 
+/**
+ * @brief Writes a block of samples to the wavefile.
+ *
+ * Writes count 32 bit left justified signed samples (interleaved, in file channel
+ * order). The samples are packed into an internal staging buffer, which is written
+ * to the file when it is full, on cl_wavwrite_flush() and on cl_wavwrite_close().
+ *
+ * NOTE:  Only available in the single core simulator.
+ *
+ * @param[in]   handle
+ *              Wavewrite stream handle.
+ *
+ * @param[in]   samples
+ *              Array of 32 bit left justified signed samples.
+ *
+ * @param[in]   count
+ *              Number of samples in the array.
+ *
+ * @param[in]   rounding
+ *              Same as for cl_wavwrite_sendsample.
+ *
+ * C Include file: <dsp_lib/wavefile.h>
+ *
+ * @ingroup simulator
+ *
+ */
+void cl_wavwrite_sendsamples(WAVWRITE_HANDLE* handle, const int* samples, int count, bool rounding);
+
+/**
+ * @brief Writes the staged samples to the wavefile.
+ *
+ * The wave header is not updated, this is done by cl_wavwrite_close().
+ *
+ * NOTE:  Only available in the single core simulator.
+ *
+ * @param[in]   handle
+ *              Wavewrite stream handle.
+ *
+ * C Include file: <dsp_lib/wavefile.h>
+ *
+ * @ingroup simulator
+ *
+ */
+void cl_wavwrite_flush(WAVWRITE_HANDLE* handle);
+
+/**
+ * @brief Writes the staged samples and updates the RIFF and data sizes in the header.
+ *
+ * The file stays open, so the file on disk is a valid wave file up to the last sample
+ * written, without the cost of cl_wavwrite_close() / cl_wavwrite_reopen().
+ *
+ * NOTE:  Only available in the single core simulator.
+ *
+ * @param[in]   handle
+ *              Wavewrite stream handle.
+ *
+ * C Include file: <dsp_lib/wavefile.h>
+ *
+ * @ingroup simulator
+ *
+ */
+void cl_wavwrite_update_sizes(WAVWRITE_HANDLE* handle);
+
+/**
+ * @brief Sets the size of the staging buffer used by cl_wavwrite_sendsamples().
+ *
+ * The default is 64 KiB. A larger buffer means fewer and larger fwrite calls,
+ * e.g. for batch rendering. The staged samples are written to the file first.
+ *
+ * NOTE:  Only available in the single core simulator.
+ *
+ * @param[in]   handle
+ *              Wavewrite stream handle.
+ *
+ * @param[in]   size
+ *              Buffer size in bytes, limited to 1 MiB.
+ *
+ * @return      The buffer size in use, -1 on error.
+ *
+ * C Include file: <dsp_lib/wavefile.h>
+ *
+ * @ingroup simulator
+ *
+ */
+int cl_wavwrite_set_buffer_size(WAVWRITE_HANDLE* handle, int size);
+
 /**
  * @brief Returns how many samples have been written to the wave file.
  *
@@ -0,0 +1,8 @@
+# Builds the kernel tests and benchmarks into tests/bin. Run from the repository root:
+# bash tests/build.sh [compiler args], e.g. -DHAOS_PCM_FLOAT32=1 or -DHAOS_BRICK_SIZE=64
+mkdir -p tests/bin
+g++ -O2 tests/fx_simd_test.cpp proc/fx/fx_simd.cpp proc/fx/fx_q31.cpp -Iproc/fx/ -Isys/haos -Isys/wave -Iutils -o tests/bin/fx_simd_test "$@"
+g++ -O2 tests/ramp_bench.cpp -Isys/haos -Isys/wave -Iutils -o tests/bin/ramp_bench "$@"
+g++ -O2 tests/fir_bench.cpp proc/fx/fx_simd.cpp proc/fx/fx_q31.cpp -Iproc/fx/ -Isys/haos -Isys/wave -Iutils -o tests/bin/fir_bench "$@"
+g++ -O2 tests/mp3_hybrid_test.cpp -Idec/mp3 -o tests/bin/mp3_hybrid_test "$@"
+g++ -O2 tests/mp3_hybrid_bench.cpp -Idec/mp3 -o tests/bin/mp3_hybrid_bench "$@"
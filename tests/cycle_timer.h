@@ -0,0 +1,46 @@
+/*
+ * cycle_timer.h
+ *
+ * Time stamp counter reads for the micro-benchmarks in tests. The counter runs at a
+ * constant rate, so the counts match core cycles when the core runs at its base clock.
+ */
+
+#ifndef CYCLE_TIMER_H__
+#define CYCLE_TIMER_H__
+
+#include <stdint.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+static inline uint64_t cycleCount()
+{
+	return __rdtsc();
+}
+
+// Calls body reps times per round and returns the cycles per call of the fastest round,
+// the slower rounds were interrupted or ran with cold caches
+template <typename Body>
+static double minCycles(int rounds, int reps, Body body)
+{
+	uint64_t best = UINT64_MAX;
+
+	for (int round = 0; round < rounds; round++)
+	{
+		uint64_t start = cycleCount();
+
+		for (int rep = 0; rep < reps; rep++)
+		{
+			body();
+		}
+
+		uint64_t cycles = cycleCount() - start;
+		best = cycles < best ? cycles : best;
+	}
+
+	return (double)best / reps;
+}
+
+#endif /* CYCLE_TIMER_H__ */
@@ -0,0 +1,140 @@
+// Measures the cycles per sample of the FX CH1 low-pass FIR (31 taps): the per-sample
+// shift register filter FX used before firBlock(), and the brick FIR of firBlock() in
+// proc/fx/fx.cpp with every kernel table the CPU supports, plain and folded (FX_FIR_SYMMETRIC).
+// Build with tests/build.sh.
+
+#include <stdio.h>
+#include <random>
+#include "fx_simd.h"
+#include "cycle_timer.h"
+
+#define NTAPS           31
+#define ROUNDS          200
+#define REPS            200
+
+// Same layout as FirState in fx.cpp: the delay line is kept twice (mirrored), so the newest
+// FIR_LINE_SIZE samples are contiguous
+#define FIR_LINE_SIZE (NTAPS - 1 + BRICK_SIZE)
+
+typedef struct
+{
+    FX_Sample_t line[2 * FIR_LINE_SIZE];
+    int head;
+} FirState;
+
+static double input[BRICK_SIZE];
+static double coeffs[NTAPS];
+
+//==============================================================================
+// Before: one sample per call, the delay line is shifted for every sample
+//==============================================================================
+
+static double history[NTAPS];
+
+static double fir(double input, const double* coeffs, double* history, unsigned int ntaps)
+{
+    int i;
+    double ret = 0;
+
+    for (i = ntaps - 2; i >= 0; i--)
+    {
+        history[i + 1] = history[i];
+    }
+
+    history[0] = input;
+
+    for (i = 0; i < (int)ntaps; i++)
+    {
+        ret += coeffs[i] * history[i];
+    }
+
+    return ret;
+}
+
+static void firPerSample(double* output)
+{
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        output[s] = fir(input[s], coeffs, history, NTAPS);
+    }
+}
+
+//==============================================================================
+// After: one brick per call, like firBlock() in fx.cpp
+//==============================================================================
+
+static FirState state;
+static FX_Sample_t brickInput[BRICK_SIZE];
+static FX_Sample_t brickCoeffs[NTAPS];
+
+static void firBlock(const FX_Kernels* kernels, bool symmetric, FX_Sample_t* output)
+{
+    FX_Sample_t* line = state.line;
+    int head = state.head;
+
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        line[head] = brickInput[s];
+        line[head + FIR_LINE_SIZE] = brickInput[s];
+        if (++head == FIR_LINE_SIZE)
+        {
+            head = 0;
+        }
+    }
+    state.head = head;
+
+    const FX_Sample_t* x = &line[head + FIR_LINE_SIZE - BRICK_SIZE];
+
+    if (symmetric)
+    {
+        kernels->firSymmetric(x, brickCoeffs, NTAPS, output);
+    }
+    else
+    {
+        kernels->fir(x, brickCoeffs, NTAPS, output);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> sample(-1.0, 1.0);
+    static double output[BRICK_SIZE];
+    static FX_Sample_t brickOutput[BRICK_SIZE];
+
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        input[s] = sample(rng) * 0.5;
+        brickInput[s] = FX_toSample(input[s]);
+    }
+
+    // symmetric like the LPF tables of fx.cpp
+    for (int i = 0; i <= NTAPS / 2; i++)
+    {
+        coeffs[i] = coeffs[NTAPS - 1 - i] = sample(rng) * 0.1;
+    }
+    for (int i = 0; i < NTAPS; i++)
+    {
+        brickCoeffs[i] = FX_toSample(coeffs[i]);
+    }
+
+    printf("Brick size: %d samples, %d-tap FIR, cycles per sample\n", BRICK_SIZE, NTAPS);
+    printf("  %-22s %6.1f\n", "per-sample fir()",
+        minCycles(ROUNDS, REPS, [&]() { firPerSample(output); }) / BRICK_SIZE);
+
+    const FX_Kernels* const* sets = FX_getKernelSets();
+
+    for (int k = 0; sets[k]; k++)
+    {
+        for (int symmetric = 0; symmetric < 2; symmetric++)
+        {
+            char name[64];
+
+            snprintf(name, sizeof(name), "firBlock %s%s", sets[k]->name, symmetric ? " folded" : "");
+            printf("  %-22s %6.1f\n", name,
+                minCycles(ROUNDS, REPS, [&]() { firBlock(sets[k], symmetric, brickOutput); }) / BRICK_SIZE);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Checks the FX SIMD kernels against the scalar ones and measures their throughput.
+// Feeds random bricks through every kernel table the CPU supports (see FX_getKernelSets),
+// fails if an output sample is more than 1 ULP off the scalar one and prints Msamples/s
+// per kernel table for one core. Build with tests/build.sh.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include "fx_simd.h"
+
+#define NTAPS           31
+#define TEST_BRICKS     20000
+#define BENCH_BRICKS    200000
+
+#if !FX_Q31
+
+// Distance of two samples in units in the last place
+static uint64_t ulpDiff(FX_Sample_t a, FX_Sample_t b)
+{
+#if HAOS_PCM_FLOAT32
+    int32_t ia, ib;
+#else
+    int64_t ia, ib;
+#endif
+
+    memcpy(&ia, &a, sizeof(ia));
+    memcpy(&ib, &b, sizeof(ib));
+
+    // map the sign-magnitude bits to a monotonic integer scale
+    if (ia < 0) ia = (decltype(ia))((uint64_t)1 << (sizeof(ia) * 8 - 1)) - ia;
+    if (ib < 0) ib = (decltype(ib))((uint64_t)1 << (sizeof(ib) * 8 - 1)) - ib;
+
+    return ia > ib ? (uint64_t)ia - (uint64_t)ib : (uint64_t)ib - (uint64_t)ia;
+}
+
+static uint64_t maxUlpDiff(const FX_Sample_t* a, const FX_Sample_t* b)
+{
+    uint64_t maxDiff = 0;
+
+    for (int s = 0; s < BRICK_SIZE; s++)
+    {
+        uint64_t diff = ulpDiff(a[s], b[s]);
+        maxDiff = diff > maxDiff ? diff : maxDiff;
+    }
+
+    return maxDiff;
+}
+
+// One brick of input with the FIR history in front of it
+typedef struct
+{
+    FX_Sample_t line[NTAPS - 1 + BRICK_SIZE];
+    FX_Sample_t other[BRICK_SIZE];
+    FX_Sample_t coeffs[NTAPS];
+    FX_Sample_t symmetricCoeffs[NTAPS];
+    FX_Sample_t gain;
+} TestBrick;
+
+static void randomBrick(std::mt19937& rng, TestBrick* brick)
+{
+    std::uniform_real_distribution<double> sample(-1.0, 1.0);
+    std::uniform_real_distribution<double> coeff(-0.2, 0.2);
+
+    for (FX_Sample_t& x : brick->line) x = FX_toSample(sample(rng));
+    for (FX_Sample_t& x : brick->other) x = FX_toSample(sample(rng));
+    for (int i = 0; i < NTAPS; i++) brick->coeffs[i] = FX_toSample(coeff(rng));
+    for (int i = 0; i <= NTAPS / 2; i++)
+    {
+        brick->symmetricCoeffs[i] = brick->symmetricCoeffs[NTAPS - 1 - i] = FX_toSample(coeff(rng));
+    }
+
+    // the mix goes past the limits now and then
+    brick->gain = FX_toSample(sample(rng) * 1.5);
+}
+
+// Runs every kernel of a table on a brick, the outputs are laid out one after another
+static void runKernels(const FX_Kernels* kernels, const TestBrick* brick, FX_Sample_t output[4][BRICK_SIZE])
+{
+    const FX_Sample_t* x = &brick->line[NTAPS - 1];
+
+    kernels->scale(x, brick->gain, output[0]);
+    kernels->fir(x, brick->coeffs, NTAPS, output[1]);
+    kernels->firSymmetric(x, brick->symmetricCoeffs, NTAPS, output[2]);
+    kernels->mixLimit(x, brick->gain, brick->other, output[3]);
+}
+
+// Checks a kernel table against the scalar one, returns the largest difference
+static uint64_t checkKernels(const FX_Kernels* kernels)
+{
+    static const char* names[4] = { "scale", "fir", "firSymmetric", "mixLimit" };
+    const FX_Kernels* scalar = FX_getScalarKernels();
+    std::mt19937 rng(1);
+    uint64_t maxDiff[4] = { 0 };
+    uint64_t worst = 0;
+
+    for (int b = 0; b < TEST_BRICKS; b++)
+    {
+        TestBrick brick;
+        FX_Sample_t expected[4][BRICK_SIZE];
+        FX_Sample_t actual[4][BRICK_SIZE];
+
+        randomBrick(rng, &brick);
+        runKernels(scalar, &brick, expected);
+        runKernels(kernels, &brick, actual);
+
+        for (int k = 0; k < 4; k++)
+        {
+            uint64_t diff = maxUlpDiff(expected[k], actual[k]);
+            maxDiff[k] = diff > maxDiff[k] ? diff : maxDiff[k];
+        }
+    }
+
+    for (int k = 0; k < 4; k++)
+    {
+        printf("  %-12s max %llu ULP\n", names[k], (unsigned long long)maxDiff[k]);
+        worst = maxDiff[k] > worst ? maxDiff[k] : worst;
+    }
+
+    return worst;
+}
+
+// Runs the FX chain of one channel pair (pre gain, FIR, mix and limit) over many bricks
+static double benchKernels(const FX_Kernels* kernels)
+{
+    static TestBrick brick;
+    static FX_Sample_t scaled[BRICK_SIZE];
+    static FX_Sample_t filtered[BRICK_SIZE];
+    static FX_Sample_t output[BRICK_SIZE];
+    std::mt19937 rng(2);
+
+    randomBrick(rng, &brick);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int b = 0; b < BENCH_BRICKS; b++)
+    {
+        kernels->scale(&brick.line[NTAPS - 1], brick.gain, scaled);
+        kernels->firSymmetric(&brick.line[NTAPS - 1], brick.symmetricCoeffs, NTAPS, filtered);
+        kernels->mixLimit(filtered, brick.gain, scaled, output);
+
+        // keep the loop from being folded, the input changes a little every brick
+        brick.line[NTAPS - 1 + (b % BRICK_SIZE)] = output[b % BRICK_SIZE];
+    }
+
+    std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+    return (double)BENCH_BRICKS * BRICK_SIZE / seconds.count() / 1e6;
+}
+
+int main()
+{
+    const FX_Kernels* const* sets = FX_getKernelSets();
+    int failed = 0;
+
+    printf("Brick size: %d samples, %d-tap FIR\n", BRICK_SIZE, NTAPS);
+
+    for (int k = 0; sets[k]; k++)
+    {
+        printf("%s\n", sets[k]->name);
+
+        if (k > 0 && checkKernels(sets[k]) > 1)
+        {
+            printf("  FAILED: more than 1 ULP off the scalar kernels\n");
+            failed = 1;
+        }
+
+        printf("  %.1f Msamples/s (scale + FIR + mix/limit, one core)\n", benchKernels(sets[k]));
+    }
+
+    return failed;
+}
+
+#else
+
+int main()
+{
+    printf("FX_Q31 uses the scalar Q31 kernels only, nothing to compare\n");
+    return 0;
+}
+
+#endif
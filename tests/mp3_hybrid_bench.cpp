@@ -0,0 +1,309 @@
+// Measures the hybrid filterbank of the MP3 decoder per function, scalar and with each SIMD set
+// the CPU supports: compute_antialias and compute_imdct per granule, imdct36 (long blocks) and
+// imdct_short (short blocks) per band. The granules come from decoding a corpus of frames,
+// tests/data/clip.mp3 or the MP3 files given on the command line. Prints cycles; the lines are
+// copied before every call (the functions work in place) and the cycles of the copy are subtracted.
+// Build with tests/build.sh.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "mp3_hybrid_sets.h"
+#include "cycle_timer.h"
+
+#define ROUNDS          200
+#define REPS            20
+
+// Input of compute_imdct: the granule after the antialias and the overlap of the previous one
+typedef struct
+{
+    granule_t g;
+    int32_t mdctBuf[SBLIMIT * 18];
+} CorpusGranule;
+
+static std::vector<granule_t> antialiasCorpus;
+static std::vector<CorpusGranule> imdctCorpus;
+
+// Recorded in place of the decoder's hybrid filterbank, which runs the scalar code
+static void recordAntialias(mp3_context_t* s, granule_t* g)
+{
+    antialiasCorpus.push_back(*g);
+    compute_antialias(s, g);
+}
+
+static void recordImdct(mp3_context_t* s, granule_t* g, int32_t* sb_samples, int32_t* mdct_buf)
+{
+    CorpusGranule c;
+
+    c.g = *g;
+    memcpy(c.mdctBuf, mdct_buf, sizeof(c.mdctBuf));
+    imdctCorpus.push_back(c);
+    compute_imdct(s, g, sb_samples, mdct_buf);
+}
+
+static bool decodeFile(const char* path)
+{
+    static short pcm[MP3_MAX_SAMPLES_PER_FRAME];
+    FILE* file = fopen(path, "rb");
+
+    if (!file)
+    {
+        printf("Cannot open %s\n", path);
+        return false;
+    }
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t cnt;
+
+    while ((cnt = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + cnt);
+    }
+    fclose(file);
+
+    mp3_decoder_t decoder = mp3_create();
+    hybrid_antialias = recordAntialias;
+    hybrid_imdct = recordImdct;
+
+    // one frame per call, a byte is skipped where no frame is found
+    for (size_t pos = 0; pos < data.size(); )
+    {
+        mp3_info_t info;
+        int bytes = (int)(data.size() - pos);
+        int frameBytes = mp3_decode(decoder, &data[pos], bytes > MP3_MAX_CODED_FRAME_SIZE ? MP3_MAX_CODED_FRAME_SIZE : bytes, pcm, &info);
+
+        pos += frameBytes > 0 ? frameBytes : 1;
+    }
+
+    return true;
+}
+
+// Long and short bands of the corpus, in groups of 8 bands from an even band
+typedef struct
+{
+    const CorpusGranule* granule;
+    int band;
+} BandGroup;
+
+static std::vector<BandGroup> longGroups, shortGroups;
+
+static void findBandGroups()
+{
+    for (const CorpusGranule& c : imdctCorpus)
+    {
+        int sblimit = compute_sblimit((granule_t*)&c.g);
+        int longEnd = c.g.block_type == 2 ? (c.g.switch_point ? 2 : 0) : sblimit;
+
+        // the two long bands of a switch point are left to the scalar code
+        for (int j = c.g.switch_point ? 8 : 0; j + 8 <= longEnd; j += 8)
+        {
+            longGroups.push_back({ &c, j });
+        }
+        for (int j = (longEnd + 7) & ~7; j + 8 <= sblimit; j += 8)
+        {
+            shortGroups.push_back({ &c, j });
+        }
+    }
+}
+
+static mp3_context_t* context;
+static granule_t g;
+static int32_t sbSamples[18 * SBLIMIT];
+static int32_t mdctBuf[SBLIMIT * 18];
+
+// Cycles per granule, a NULL function only copies the lines
+static double antialiasCycles(Antialias_t antialias)
+{
+    return minCycles(ROUNDS, REPS, [&]()
+    {
+        for (const granule_t& c : antialiasCorpus)
+        {
+            g.block_type = c.block_type;
+            g.switch_point = c.switch_point;
+            memcpy(g.sb_hybrid, c.sb_hybrid, sizeof(g.sb_hybrid));
+            if (antialias)
+            {
+                antialias(context, &g);
+            }
+        }
+    }) / antialiasCorpus.size();
+}
+
+static double imdctCycles(Imdct_t imdct)
+{
+    return minCycles(ROUNDS, REPS, [&]()
+    {
+        for (const CorpusGranule& c : imdctCorpus)
+        {
+            g.block_type = c.g.block_type;
+            g.switch_point = c.g.switch_point;
+            memcpy(g.sb_hybrid, c.g.sb_hybrid, sizeof(g.sb_hybrid));
+            memcpy(mdctBuf, c.mdctBuf, sizeof(mdctBuf));
+            if (imdct)
+            {
+                imdct(context, &g, sbSamples, mdctBuf);
+            }
+        }
+    }) / imdctCorpus.size();
+}
+
+// Cycles per band of imdct36 or imdct_short, set: index in hybridSets, -1 for the scalar code,
+// -2 only copies the lines
+static double bandCycles(const std::vector<BandGroup>& groups, bool shortBlocks, int set)
+{
+    return minCycles(ROUNDS, REPS, [&]()
+    {
+        for (const BandGroup& group : groups)
+        {
+            int blockType = group.granule->g.block_type;
+            const int32_t* in = group.granule->g.sb_hybrid + 18 * group.band;
+
+            memcpy(g.sb_hybrid, in, 8 * 18 * sizeof(int32_t));
+            memcpy(mdctBuf, group.granule->mdctBuf + 18 * group.band, 8 * 18 * sizeof(int32_t));
+
+            if (set == -1)
+            {
+                for (int j = 0; j < 8; j++)
+                {
+                    int32_t* win = mdct_win[blockType] + ((4 * 36) & -(j & 1));
+
+                    if (shortBlocks)
+                    {
+                        imdct_short(sbSamples + j, mdctBuf + 18 * j, g.sb_hybrid + 18 * j, win);
+                    }
+                    else
+                    {
+                        imdct36(sbSamples + j, mdctBuf + 18 * j, g.sb_hybrid + 18 * j, win);
+                    }
+                }
+            }
+#if MINIMP3_SIMD_X86
+            else if (set >= 0)
+            {
+                const HybridSet* s = &hybridSets[set];
+                BandKernel_t kernel = shortBlocks ? s->imdctShort : s->imdct36;
+
+                for (int j = 0; j < 8; j += s->lanes)
+                {
+                    kernel(sbSamples + j, mdctBuf + 18 * j, g.sb_hybrid + 18 * j, mdct_win_lanes[blockType]);
+                }
+            }
+#endif
+        }
+    }) / (groups.size() * 8);
+}
+
+// One line per function, scalar first
+static void printRow(const char* function, const char* unit, double scalar, const double* simd, int simdCnt)
+{
+    printf("  %-18s %-8s %8.1f", function, unit, scalar);
+    for (int k = 0; k < simdCnt; k++)
+    {
+        if (simd[k] >= 0)
+        {
+            printf(" %8.1f", simd[k]);
+        }
+        else
+        {
+            printf(" %8s", "-");
+        }
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    context = (mp3_context_t*)mp3_create();
+
+    if (argc < 2)
+    {
+        if (!decodeFile("tests/data/clip.mp3"))
+        {
+            return 1;
+        }
+    }
+    for (int a = 1; a < argc; a++)
+    {
+        if (!decodeFile(argv[a]))
+        {
+            return 1;
+        }
+    }
+
+    findBandGroups();
+
+    long blockTypes[4][2] = { { 0 } };
+    for (const CorpusGranule& c : imdctCorpus)
+    {
+        blockTypes[c.g.block_type][c.g.switch_point]++;
+    }
+
+    printf("%zu granules (block type/switch point:", imdctCorpus.size());
+    for (int bt = 0; bt < 4; bt++)
+    {
+        printf(" %d:%ld/%ld", bt, blockTypes[bt][0], blockTypes[bt][1]);
+    }
+    printf("), %zu long and %zu short bands in groups of 8\n", longGroups.size() * 8, shortGroups.size() * 8);
+
+    if (imdctCorpus.empty())
+    {
+        return 1;
+    }
+
+    double antialiasCopy = antialiasCycles(NULL);
+    double imdctCopy = imdctCycles(NULL);
+    double band36Copy = longGroups.empty() ? 0 : bandCycles(longGroups, false, -2);
+    double band12Copy = shortGroups.empty() ? 0 : bandCycles(shortGroups, true, -2);
+    double antialias, imdct, band36 = -1, band12 = -1;
+    int simdCnt = 0;
+
+#if MINIMP3_SIMD_X86
+    double simdAntialias[HYBRID_SET_CNT], simdImdct[HYBRID_SET_CNT], simd36[HYBRID_SET_CNT], simd12[HYBRID_SET_CNT];
+
+    simdCnt = HYBRID_SET_CNT;
+    for (int k = 0; k < simdCnt; k++)
+    {
+        bool supported = hybridSets[k].supported();
+
+        simdAntialias[k] = supported ? antialiasCycles(hybridSets[k].antialias) - antialiasCopy : -1;
+        simdImdct[k] = supported ? imdctCycles(hybridSets[k].imdct) - imdctCopy : -1;
+        simd36[k] = supported && !longGroups.empty() ? bandCycles(longGroups, false, k) - band36Copy : -1;
+        simd12[k] = supported && !shortGroups.empty() ? bandCycles(shortGroups, true, k) - band12Copy : -1;
+    }
+#else
+    double* simdAntialias = NULL, * simdImdct = NULL, * simd36 = NULL, * simd12 = NULL;
+#endif
+
+    antialias = antialiasCycles(compute_antialias) - antialiasCopy;
+    imdct = imdctCycles(compute_imdct) - imdctCopy;
+    if (!longGroups.empty())
+    {
+        band36 = bandCycles(longGroups, false, -1) - band36Copy;
+    }
+    if (!shortGroups.empty())
+    {
+        band12 = bandCycles(shortGroups, true, -1) - band12Copy;
+    }
+
+    printf("  %-18s %-8s %8s", "Cycles", "", "scalar");
+#if MINIMP3_SIMD_X86
+    for (int k = 0; k < simdCnt; k++)
+    {
+        printf(" %8s", hybridSets[k].name);
+    }
+#endif
+    printf("\n");
+    printRow("compute_antialias", "/granule", antialias, simdAntialias, simdCnt);
+    printRow("compute_imdct", "/granule", imdct, simdImdct, simdCnt);
+    if (band36 >= 0)
+    {
+        printRow("imdct36", "/band", band36, simd36, simdCnt);
+    }
+    if (band12 >= 0)
+    {
+        printRow("imdct_short", "/band", band12, simd12, simdCnt);
+    }
+
+    return 0;
+}
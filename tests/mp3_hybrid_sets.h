@@ -0,0 +1,44 @@
+/*
+ * mp3_hybrid_sets.h
+ *
+ * The SIMD hybrid filterbank functions of the MP3 decoder for the tests in tests: minimp3.cpp
+ * is included for its static functions, and the vector functions of each instruction set
+ * (see dec/mp3/minimp3_hybrid_template.h) are listed in one table.
+ */
+
+#ifndef MP3_HYBRID_SETS_H__
+#define MP3_HYBRID_SETS_H__
+
+#include "minimp3.cpp"
+
+typedef void (*Antialias_t)(mp3_context_t* s, granule_t* g);
+typedef void (*Imdct_t)(mp3_context_t* s, granule_t* g, int32_t* sb_samples, int32_t* mdct_buf);
+
+#if MINIMP3_SIMD_X86
+
+// imdct36 or imdct_short of HYBRID_LANES bands, win: mdct_win_lanes[block_type]
+typedef void (*BandKernel_t)(int32_t* out, int32_t* buf, const int32_t* in, const int32_t (*win)[8]);
+
+// The vector functions of one instruction set
+typedef struct
+{
+    const char* name;
+    int (*supported)(void);
+    int lanes;
+    Antialias_t antialias;
+    Imdct_t imdct;
+    BandKernel_t imdct36;
+    BandKernel_t imdctShort;
+} HybridSet;
+
+static const HybridSet hybridSets[] =
+{
+    { "SSE4.1", cpu_has_sse41, 4, compute_antialias_sse41, compute_imdct_sse41, imdct36_sse41, imdct_short_sse41 },
+    { "AVX2", cpu_has_avx2, 8, compute_antialias_avx2, compute_imdct_avx2, imdct36_avx2, imdct_short_avx2 },
+};
+
+#define HYBRID_SET_CNT (int)(sizeof(hybridSets) / sizeof(hybridSets[0]))
+
+#endif // MINIMP3_SIMD_X86
+
+#endif /* MP3_HYBRID_SETS_H__ */
@@ -0,0 +1,195 @@
+// Checks the SSE4.1 and AVX2 hybrid filterbank of the MP3 decoder (dec/mp3/minimp3_hybrid_template.h)
+// against the scalar code. Random granules of every block type and switch point go through
+// compute_antialias and compute_imdct, random band groups through imdct36 (long blocks) and
+// imdct_short (three imdct12, short blocks); every output must be bit exact. Build with
+// tests/build.sh.
+
+#include <stdio.h>
+#include <string.h>
+#include <random>
+#include "mp3_hybrid_sets.h"
+
+#define TEST_GRANULES   100000
+#define TEST_GROUPS     100000
+
+#if MINIMP3_SIMD_X86
+
+// One granule and the overlap of the previous one, as compute_imdct gets them
+typedef struct
+{
+    granule_t g;
+    int32_t mdctBuf[SBLIMIT * 18];
+} TestGranule;
+
+// Random lines in the range of the dequantizer output, sparse inputs get many zero lines
+static int32_t randomLine(std::mt19937& rng, int range)
+{
+    int32_t v = (int32_t)rng();
+
+    switch (range)
+    {
+    case 0:  return v >> 20;
+    case 1:  return v >> 12;
+    case 2:  return v >> 8;
+    default: return (rng() % 7 == 0) ? v >> 12 : 0;
+    }
+}
+
+// The bands from sblimit on are zero, as in a decoded granule
+static void randomGranule(std::mt19937& rng, TestGranule* t)
+{
+    int range = rng() % 4;
+    int sblimit = 2 + rng() % 31;
+
+    memset(t, 0, sizeof(*t));
+    t->g.block_type = rng() % 4;
+    t->g.switch_point = t->g.block_type ? rng() % 2 : 0;
+
+    for (int i = 0; i < sblimit * 18; i++)
+    {
+        t->g.sb_hybrid[i] = randomLine(rng, range);
+    }
+    for (int i = 0; i < SBLIMIT * 18; i++)
+    {
+        t->mdctBuf[i] = randomLine(rng, range == 3 ? 1 : range);
+    }
+}
+
+static bool checkGranules(const HybridSet* set, mp3_context_t* s)
+{
+    std::mt19937 rng(1);
+    long mismatches = 0;
+    long cover[4][2] = { { 0 } };
+
+    for (int n = 0; n < TEST_GRANULES; n++)
+    {
+        static TestGranule expected, actual;
+        static int32_t expectedOut[18 * SBLIMIT], actualOut[18 * SBLIMIT];
+
+        randomGranule(rng, &expected);
+        actual = expected;
+        cover[expected.g.block_type][expected.g.switch_point]++;
+
+        compute_antialias(s, &expected.g);
+        set->antialias(s, &actual.g);
+        bool differs = memcmp(expected.g.sb_hybrid, actual.g.sb_hybrid, sizeof(expected.g.sb_hybrid)) != 0;
+
+        // the scalar imdct36 sums its input in place, the outputs are sb_samples and mdct_buf
+        compute_imdct(s, &expected.g, expectedOut, expected.mdctBuf);
+        set->imdct(s, &actual.g, actualOut, actual.mdctBuf);
+        differs |= memcmp(expectedOut, actualOut, sizeof(expectedOut)) || memcmp(expected.mdctBuf, actual.mdctBuf, sizeof(expected.mdctBuf));
+
+        if (differs)
+        {
+            if (mismatches++ < 5)
+            {
+                printf("  granule %d differs (block type %d, switch point %d)\n", n, expected.g.block_type, expected.g.switch_point);
+            }
+        }
+    }
+
+    printf("  compute_antialias + compute_imdct: %d granules, %ld differ (block type/switch point:", TEST_GRANULES, mismatches);
+    for (int bt = 0; bt < 4; bt++)
+    {
+        printf(" %d:%ld/%ld", bt, cover[bt][0], cover[bt][1]);
+    }
+    printf(")\n");
+
+    return mismatches == 0;
+}
+
+// 8 bands through one kernel, scalar band by band and vector a lane group at a time
+static bool checkBands(const HybridSet* set, bool shortBlocks)
+{
+    const char* name = shortBlocks ? "imdct_short" : "imdct36";
+    std::mt19937 rng(2);
+    long mismatches = 0;
+
+    for (int n = 0; n < TEST_GROUPS; n++)
+    {
+        // long blocks use the windows of block types 0, 1 and 3
+        static const int longTypes[3] = { 0, 1, 3 };
+        int blockType = shortBlocks ? 2 : longTypes[rng() % 3];
+        int range = rng() % 4;
+        int32_t in[8 * 18], scalarIn[8 * 18];
+        int32_t expectedBuf[8 * 18], actualBuf[8 * 18];
+        int32_t expectedOut[18 * SBLIMIT] = { 0 }, actualOut[18 * SBLIMIT] = { 0 };
+
+        for (int i = 0; i < 8 * 18; i++)
+        {
+            in[i] = randomLine(rng, range);
+            expectedBuf[i] = actualBuf[i] = randomLine(rng, range == 3 ? 1 : range);
+        }
+
+        // the scalar imdct36 sums its input in place
+        memcpy(scalarIn, in, sizeof(in));
+
+        for (int j = 0; j < 8; j++)
+        {
+            int32_t* win = mdct_win[blockType] + ((4 * 36) & -(j & 1));
+
+            if (shortBlocks)
+            {
+                imdct_short(expectedOut + j, expectedBuf + 18 * j, scalarIn + 18 * j, win);
+            }
+            else
+            {
+                imdct36(expectedOut + j, expectedBuf + 18 * j, scalarIn + 18 * j, win);
+            }
+        }
+
+        for (int j = 0; j < 8; j += set->lanes)
+        {
+            BandKernel_t kernel = shortBlocks ? set->imdctShort : set->imdct36;
+            kernel(actualOut + j, actualBuf + 18 * j, in + 18 * j, mdct_win_lanes[blockType]);
+        }
+
+        if (memcmp(expectedOut, actualOut, sizeof(expectedOut)) || memcmp(expectedBuf, actualBuf, sizeof(expectedBuf)))
+        {
+            if (mismatches++ < 5)
+            {
+                printf("  %s group %d differs (block type %d)\n", name, n, blockType);
+            }
+        }
+    }
+
+    printf("  %-12s %d groups of 8 bands, %ld differ\n", name, TEST_GROUPS, mismatches);
+
+    return mismatches == 0;
+}
+
+int main()
+{
+    // builds the tables and the lane windows
+    mp3_context_t* s = (mp3_context_t*)mp3_create();
+    int failed = 0;
+
+    for (const HybridSet& set : hybridSets)
+    {
+        printf("%s\n", set.name);
+
+        if (!set.supported())
+        {
+            printf("  not supported by this CPU\n");
+            continue;
+        }
+
+        if (!checkGranules(&set, s) || !checkBands(&set, false) || !checkBands(&set, true))
+        {
+            printf("  FAILED: not bit exact with the scalar code\n");
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
+
+#else
+
+int main()
+{
+    printf("No SIMD hybrid filterbank in this build (MINIMP3_SIMD=0 or not x86), nothing to compare\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,60 @@
+// Measures the per-sample cost of GainRamp::apply() (sys/haos/haos_ramp.h): a channel at gain 1
+// (copy), at a constant gain and in the middle of a ramp, to a separate brick and in place.
+// Prints cycles per sample and the cost of the ramp over the constant gain. Build with tests/build.sh.
+
+#include <stdio.h>
+#include <random>
+#include "haos_ramp.h"
+#include "cycle_timer.h"
+
+#define ROUNDS		200
+#define REPS		1000
+
+static HAOS_PcmSample_t src[BRICK_SIZE];
+static HAOS_PcmSample_t dst[BRICK_SIZE];
+
+// Cycles per sample of apply() on channel 0, with the gain ramp set up by the caller
+static double benchApply(HAOS_GainRamp_t* ramp, bool inPlace)
+{
+	HAOS_PcmSample_t* out = inPlace ? src : dst;
+
+	return minCycles(ROUNDS, REPS, [&]() { GainRamp::apply(ramp, 0, src, out); }) / BRICK_SIZE;
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> sample(-1.0, 1.0);
+	HAOS_GainRamp_t ramp;
+
+	for (int s = 0; s < BRICK_SIZE; s++)
+	{
+		src[s] = (HAOS_PcmSample_t)sample(rng);
+	}
+
+	printf("Brick size: %d samples, cycles per sample\n", BRICK_SIZE);
+
+	for (int inPlace = 0; inPlace < 2; inPlace++)
+	{
+		double unity, constant, ramping;
+
+		GainRamp::init(&ramp, 0, 1);
+		unity = benchApply(&ramp, inPlace);
+
+		// -1 keeps the in-place samples from decaying into denormals
+		GainRamp::init(&ramp, 0, -1);
+		constant = benchApply(&ramp, inPlace);
+
+		// the ramp doesn't end during the benchmark and stays close to 1 for the same reason
+		GainRamp::init(&ramp, 1 << 30, 1);
+		GainRamp::setTarget(&ramp, 0, (HAOS_PcmSample_t)0.999);
+		ramping = benchApply(&ramp, inPlace);
+
+		printf("%s\n", inPlace ? "in place" : "separate output");
+		printf("  unity     %6.2f\n", unity);
+		printf("  constant  %6.2f\n", constant);
+		printf("  ramping   %6.2f (+%.2f over constant)\n", ramping, ramping - constant);
+	}
+
+	return 0;
+}
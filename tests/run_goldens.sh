@@ -0,0 +1,97 @@
+#!/bin/bash
+# Builds haOS with the module tables the goldens need, renders the clips in tests/data and
+# checks the outputs against tests/goldens.md5. Run from anywhere: tests/run_goldens.sh
+# Extra arguments go to the compiler (e.g. -DHAOS_BRICK_SIZE=64, the goldens are for the default).
+
+cd "$(dirname "$0")/.." || exit 1
+OUT=$(mktemp -d)
+trap 'rm -rf "$OUT"' EXIT
+failed=0
+
+# <output> <first sample that differs from <reference>> <reference> <channels>
+checkFirstChange()
+{
+	local expected=$((44 + $2 * $4 * 2 + 1))
+	local first=$(cmp "$OUT/$1" "$OUT/$3" | sed -n 's/.*differ: \(byte\|char\) \([0-9]*\).*/\2/p')
+
+	if [ "$first" != "$expected" ]; then
+		echo "$1: first change at byte ${first:-none}, expected $expected (sample $2)"
+		failed=1
+	fi
+}
+
+# Ctrl+C in the middle of a long MP3 stream: haOS stops after the current frame, exits with 0
+# and leaves a WAV file whose header matches its length. The first clip of the long stream
+# decodes like the clip itself, up to its last frames.
+# <name> <haos arguments>
+checkSigint()
+{
+	local name=$1
+	shift
+
+	timeout -s KILL 20 "$OUT/haos_mp3" --app 1 --input "$OUT/long.mp3" --output "$OUT/$name" "$@" > /dev/null &
+	local pid=$!
+	sleep 0.5
+	kill -INT $pid
+	wait $pid
+	local status=$?
+
+	local size=$(stat -c %s "$OUT/$name")
+	local riffSize=$(od -An -tu4 -j4 -N4 "$OUT/$name" | tr -d ' ')
+	local dataSize=$(od -An -tu4 -j40 -N4 "$OUT/$name" | tr -d ' ')
+
+	if [ $status -ne 0 ] || [ "$riffSize" != $((size - 8)) ] || [ "$dataSize" != $((size - 44)) ]; then
+		echo "$name: exit $status, $size bytes, RIFF size $riffSize, data size $dataSize"
+		failed=1
+	elif [ $size -ge $((44 + LONG_CLIPS * 43 * 1152 * 6 * 2)) ]; then
+		echo "$name: not stopped by Ctrl+C"
+		failed=1
+	elif ! cmp -s -i 44 -n $((40 * 1152 * 6 * 2)) "$OUT/$name" "$OUT/mp3.wav"; then
+		echo "$name: differs from mp3.wav at the start"
+		failed=1
+	fi
+}
+
+# the PCM chain on core 0, split over cores 0/1/2, and with the MP3 decoder on core 0
+# <binary> <compiler arguments>
+build()
+{
+	local binary=$1
+	shift
+
+	if ! bash build.sh -O2 -o "$OUT/$binary" "$@" > "$OUT/build.log" 2>&1; then
+		cat "$OUT/build.log"
+		exit 1
+	fi
+}
+
+build haos "$@"
+build haos_split -DODT_SPLIT_CORES=1 "$@"
+build haos_mp3 -DODT_MP3_DECODER=1 "$@"
+
+"$OUT/haos" --input tests/data/clip.wav --output "$OUT/clip.wav" > /dev/null
+"$OUT/haos" --input tests/data/clip.wav --output "$OUT/timed.wav" --cfg tests/data/timed_split.cfg > /dev/null
+"$OUT/haos_split" --input tests/data/clip.wav --output "$OUT/timed_split.wav" --cfg tests/data/timed_split.cfg > /dev/null
+"$OUT/haos_split" --input tests/data/clip.wav --output "$OUT/timed_split_seq.wav" --cfg tests/data/timed_split.cfg --sequential > /dev/null
+
+# the timed change lands on the stamped brick on every core
+checkFirstChange timed.wav 12288 clip.wav 6
+checkFirstChange timed_split.wav 12288 clip.wav 6
+checkFirstChange timed_split_seq.wav 12288 clip.wav 6
+
+# the MP3 decoder: the sync path and decode-ahead give the same PCM
+"$OUT/haos_mp3" --app 1 --input tests/data/clip.mp3 --output "$OUT/mp3.wav" > /dev/null
+for frames in 1 4 8; do
+	"$OUT/haos_mp3" --app 1 --input tests/data/clip.mp3 --output "$OUT/mp3_ahead$frames.wav" --cfg tests/data/ahead$frames.cfg > /dev/null
+done
+
+# Ctrl+C teardown, also with the decode-ahead thread running
+LONG_CLIPS=300
+for i in $(seq $LONG_CLIPS); do cat tests/data/clip.mp3; done > "$OUT/long.mp3"
+checkSigint sigint.wav
+checkSigint sigint_ahead4.wav --cfg tests/data/ahead4.cfg
+
+(cd "$OUT" && md5sum --quiet -c -) < tests/goldens.md5 || failed=1
+
+[ $failed -eq 0 ] && echo "All goldens match"
+exit $failed
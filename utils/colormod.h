@@ -25,8 +25,14 @@ namespace Color {
         Code code;
     public:
         Modifier(Code pCode) : code(pCode) {}
+        // Colours can be switched off globally, e.g. when the output goes to a log file
+        static bool& enabled() {
+            static bool on = true;
+            return on;
+        }
         friend std::ostream&
             operator<<(std::ostream& os, const Modifier& mod) {
+            if (!enabled()) return os;
             return os << "\033[" << mod.code << "m";
         }
     };